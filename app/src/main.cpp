@@ -26,6 +26,7 @@
 #include <memory>
 
 #include "popcorn/API/syscall.h"
+#include "popcorn/API/system.h"
 #include "popcorn/core/kernel.h"
 #include "popcorn/primitives/mutex.h"
 #include "popcorn/primitives/unique_lock.h"
@@ -91,11 +92,9 @@ void Popcorn::Kernel::TriggerSchedulerExitHook() {
 
 struct TaskArgs {
   Postform::InternedString interned_name;
-  const char* name;
   GPIO_TypeDef* bank;
   uint16_t pin;
   uint32_t delay;
-  uint32_t stack_size;
 };
 
 static Popcorn::Mutex mutex;
@@ -155,22 +154,17 @@ static void ConfigureClk() {
 
 void AteAssertFailed(std::uintptr_t PC) { LOG_ERROR(&logger, "ASSERT %x", PC); }
 
-void InitTask(void* args) {
-  TaskArgs** taskArgs = reinterpret_cast<TaskArgs**>(args);
-  auto& syscall = Popcorn::Syscall::Instance();
-  LOG_INFO(&logger, "Running InitTask");
+static TaskArgs s_args_task_1 = {"GPIO_C13"_intern, GPIOC, GPIO_PIN_13, 1000};
+static TaskArgs s_args_task_2 = {"GPIO_A0"_intern, GPIOA, GPIO_PIN_0, 1500};
 
-  {
-    Popcorn::UniqueLock<Popcorn::Mutex> l(mutex);
-
-    for (uint32_t i = 0; taskArgs[i] != nullptr; i++) {
-      syscall.CreateTask(gpio_task, taskArgs[i], Popcorn::Priority::Level_0,
-                         taskArgs[i]->name, taskArgs[i]->stack_size);
-    }
+// Tasks are fixed at build time. Their storage is laid out statically
+// and they are ready before the scheduler starts.
+constexpr Popcorn::task_description kTasks[] = {
+    {gpio_task, &s_args_task_1, Popcorn::Priority::Level_0, "GPIO_C13", 256},
+    {gpio_task, &s_args_task_2, Popcorn::Priority::Level_0, "GPIO_A0", 256},
+};
 
-    syscall.Sleep(1000);
-  }
-}
+static Popcorn::System<kTasks> s_system;
 
 // HAL should not use the systick, It is used by the OS
 CLINKAGE HAL_StatusTypeDef HAL_InitTick(uint32_t) { return HAL_OK; }
@@ -178,16 +172,6 @@ CLINKAGE HAL_StatusTypeDef HAL_InitTick(uint32_t) { return HAL_OK; }
 int main() {
   LOG_INFO(&logger, "Popcorn is starting up!");
 
-  struct TaskArgs args_task_1 = {"GPIO_C13"_intern, "GPIO_C13", GPIOC,
-                                 GPIO_PIN_13,       1000,       256};
-
-  struct TaskArgs args_task_2 = {"GPIO_A0"_intern, "GPIO_A0", GPIOA,
-                                 GPIO_PIN_0,       1500,      256};
-
-  struct TaskArgs* args[] = {&args_task_1, &args_task_2, nullptr};
-
-  static constexpr uint32_t InitTaskStackSize = 512;
-
   HAL_Init();
   ConfigureClk();
 
@@ -199,9 +183,6 @@ int main() {
   gpio.Speed = GPIO_SPEED_FREQ_HIGH;
   HAL_GPIO_Init(GPIOA, &gpio);
 
-  auto& syscall = Popcorn::Syscall::Instance();
-  syscall.CreateTask(InitTask, args, Popcorn::Priority::Level_0, "Init task",
-                     InitTaskStackSize);
-  syscall.StartOS();
+  s_system.Start();
   return 0;
 }
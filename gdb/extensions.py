@@ -14,50 +14,147 @@ class TCBPrettyPrinter(object):
                 "\tPriority:\t%s\n"
                 "\tState:\t\t%s\n"
                 "\tStack ptr:\t0x%08x\n"
+                "\tStack size:\t%d\n"
                 "\tArgument ptr:\t0x%08x\n" %
                 (self.val["name"].string(),
                  self.val["func"],
                  self.val["priority"],
                  self.val["state"],
                  self.val["stack_ptr"],
+                 self.val["stack_size"],
                  self.val["arg"]))
 
 class LinkedListParser(gdb.Command):
-    """Parse a LinkedList"""
+    """Parse a Popcorn::LinkedList"""
 
     def __init__(self):
         super(LinkedListParser, self).__init__(
             "ParseLinkedList", gdb.COMMAND_USER
         )
 
-    def FindListOffset(self, type):
-        for field in type.fields():
-            if str(field.type) == "LinkedList_t":
-                return int(field.bitpos / 8)
-        return 0
-
     def complete(self, text, word):
         return gdb.COMPLETE_SYMBOL
 
     def invoke(self, args, from_tty):
-        splitargs = args.split(",")
+        list_val = gdb.parse_and_eval(args)
+        if list_val.type.strip_typedefs().code == gdb.TYPE_CODE_PTR:
+            list_val = list_val.dereference()
 
-        list_ptr_val = gdb.parse_and_eval(splitargs[0])
-        if str(list_ptr_val.type) != "LinkedList_t *":
-            print("Expected argument of type (LinkedList_t *)")
+        list_type = list_val.type.strip_typedefs()
+        if not str(list_type).startswith("Popcorn::LinkedList<"):
+            print("Expected argument of type (Popcorn::LinkedList<T>)")
             return
 
-        element_type = gdb.lookup_type(splitargs[1].strip())
-        list_offset = self.FindListOffset(element_type)
-        self.ParseList(list_ptr_val, element_type, list_offset)
+        element_type = list_type.template_argument(0)
+        list_offset = FindListOffset(element_type)
+        self.ParseList(list_val, element_type, list_offset)
 
-    def ParseList(self, head, type, offset):
-        ll_p = head
-        while ll_p != 0:
-            element = ll_p.cast(gdb.lookup_type("uint8_t").pointer()) - offset
+    def ParseList(self, linked_list, type, offset):
+        for element in ListElements(linked_list, offset):
             print("Found element at address 0x%08x, printing:" % element)
             gdb.execute("p *(%s)0x%x" % (type.pointer(), element))
-            ll_p = ll_p.dereference()["next"]
+
+def FindListOffset(type):
+    """Offset of the ListNode member named list of an element type"""
+    for field in type.fields():
+        if field.name == "list" and \
+                str(field.type) == "Popcorn::ListNode":
+            return int(field.bitpos / 8)
+    return 0
+
+def ListElements(linked_list, offset):
+    """Yield the address of each element of a Popcorn::LinkedList"""
+    tail = linked_list["m_tail"].address
+    node_p = linked_list["m_head"]["next"]
+    while node_p != tail:
+        yield int(node_p.cast(gdb.lookup_type("uint8_t").pointer()) - offset)
+        node_p = node_p.dereference()["next"]
+
+class StackReport(gdb.Command):
+    """Report the stack usage of tasks and recommend a size for each stack
+
+Usage: StackReport [task_control_block expression...]
+
+Without arguments, reports the running, ready and sleeping tasks. Needs
+STACK_WATERMARK, and ISR_STACK_SIZE for the exception handler stack."""
+
+    FILL_PATTERN = 0xA5
+    # Headroom over the deepest usage seen so far
+    MARGIN = 0.25
+    DEFAULT_MINIMUM_STACK_SIZE = 256
+
+    def __init__(self):
+        super(StackReport, self).__init__("StackReport", gdb.COMMAND_USER)
+
+    def complete(self, text, word):
+        return gdb.COMPLETE_SYMBOL
+
+    def invoke(self, args, from_tty):
+        kernel = gdb.parse_and_eval("Popcorn::g_kernel").dereference()
+        tcb_type = gdb.lookup_type("Popcorn::task_control_block")
+        argv = gdb.string_to_argv(args)
+        if argv:
+            tasks = [self.AddressOf(gdb.parse_and_eval(arg)) for arg in argv]
+        else:
+            tasks = self.KernelTasks(kernel, tcb_type)
+
+        minimum = self.MinimumStackSize()
+        print("%-12s %8s %8s %12s" % ("Task", "Size", "Used", "Recommended"))
+        for address in tasks:
+            tcb = gdb.Value(address).cast(tcb_type.pointer()).dereference()
+            size = int(tcb["stack_size"])
+            used = self.HighWatermark(int(tcb["stack_base"]), size)
+            print("%-12s %8d %8d %12d" % (tcb["name"].string(), size, used,
+                                          self.Recommend(used, minimum)))
+
+        isr_size = int(kernel["m_isr_stack_size"])
+        if isr_size:
+            used = self.HighWatermark(int(kernel["m_isr_stack"]), isr_size)
+            print("%-12s %8d %8d %12d" % ("<ISR>", isr_size, used,
+                                          self.Recommend(used, 0)))
+
+    def AddressOf(self, tcb):
+        if tcb.type.strip_typedefs().code == gdb.TYPE_CODE_PTR:
+            return int(tcb)
+        return int(tcb.address)
+
+    def KernelTasks(self, kernel, tcb_type):
+        offset = FindListOffset(tcb_type)
+        tasks = []
+        if kernel["m_current_task"]:
+            tasks.append(int(kernel["m_current_task"]))
+
+        scheduler = kernel["m_scheduler"]
+        fields = [f.name for f in scheduler.type.strip_typedefs().fields()]
+        if "m_ready_lists" in fields:
+            ready_lists = scheduler["m_ready_lists"]
+            low, high = ready_lists.type.strip_typedefs().range()
+            for level in range(low, high + 1):
+                tasks += ListElements(ready_lists[level], offset)
+        elif "m_deadline_heap" in fields:
+            heap = scheduler["m_deadline_heap"]
+            tasks += [int(heap["m_tasks"][i]) for i in range(int(heap["m_size"]))]
+
+        tasks += ListElements(kernel["m_sleeping_list"], offset)
+        # The running task is also ready
+        return list(dict.fromkeys(tasks))
+
+    def HighWatermark(self, stack_base, size):
+        memory = bytes(gdb.selected_inferior().read_memory(stack_base, size))
+        unused = len(memory) - len(memory.lstrip(bytes([self.FILL_PATTERN])))
+        return size - unused
+
+    def MinimumStackSize(self):
+        try:
+            return int(gdb.parse_and_eval("MINIMUM_TASK_STACK_SIZE"))
+        except gdb.error:
+            return self.DEFAULT_MINIMUM_STACK_SIZE
+
+    def Recommend(self, used, minimum):
+        size = int(used * (1 + self.MARGIN))
+        # Stacks are kept 8 byte aligned
+        size = (size + 7) & ~7
+        return max(size, minimum)
 
 class CustomPrettyPrinterLocator(PrettyPrinter):
     """Given a gdb.Value, search for a custom pretty printer"""
@@ -80,3 +177,4 @@ class CustomPrettyPrinterLocator(PrettyPrinter):
 if __name__ == "__main__":
     register_pretty_printer(None, CustomPrettyPrinterLocator(), replace=True)
     LinkedListParser()
+    StackReport()
@@ -18,12 +18,14 @@ LOCAL_SRC := \
     $(LOCAL_DIR)/src/primitives/critical_section.cpp \
     $(LOCAL_DIR)/src/core/kernel.cpp \
     $(LOCAL_DIR)/src/core/lockable.cpp \
+    $(LOCAL_DIR)/src/utils/block_pool.cpp \
+    $(LOCAL_DIR)/src/utils/heap_tracker.cpp \
     $(LOCAL_DIR)/src/utils/memory_management.cpp \
+    $(LOCAL_DIR)/src/utils/tlsf.cpp \
     $(LOCAL_DIR)/src/primitives/mutex.cpp \
     $(LOCAL_DIR)/src/platform.cpp \
     $(LOCAL_DIR)/src/primitives/spinlock.cpp \
-    $(LOCAL_DIR)/src/core/syscalls.cpp \
-    $(LOCAL_DIR)/src/utils/linked_list.c
+    $(LOCAL_DIR)/src/core/syscalls.cpp
 
 LOCAL_EXPORTED_DIRS := \
     $(LOCAL_DIR)/inc
@@ -45,7 +47,9 @@ TEST_SRC := \
     $(LOCAL_DIR)/src/core/cortex-m_port.cpp \
     $(LOCAL_DIR)/src/core/kernel.cpp \
     $(LOCAL_DIR)/src/core/lockable.cpp \
-    $(LOCAL_DIR)/src/utils/linked_list.c \
+    $(LOCAL_DIR)/src/utils/block_pool.cpp \
+    $(LOCAL_DIR)/src/utils/heap_tracker.cpp \
+    $(LOCAL_DIR)/src/utils/tlsf.cpp \
     $(LOCAL_DIR)/src/primitives/spinlock.cpp \
     $(LOCAL_DIR)/src/primitives/mutex.cpp \
     $(LOCAL_DIR)/src/primitives/critical_section.cpp
@@ -21,6 +21,7 @@
 #include <cstdint>
 
 #include "popcorn/core/lockable.h"
+#include "popcorn/platform.h"
 
 namespace Popcorn {
 /**
@@ -49,10 +50,41 @@ enum class Priority {
   Level_9
 };
 
+/**
+ * @brief Parameters of a periodic task.
+ *
+ * A new job of the task is released every period. Each job must be
+ * completed before its deadline, relative to the release time.
+ */
+struct periodic_task_params {
+  Priority priority;
+  const char* name;
+  std::uint32_t stack_size;
+  std::uint32_t period;
+  std::uint32_t deadline;
+};
+
+/**
+ * @brief Parameters of a task created from caller provided storage.
+ *
+ * Use StaticTask to declare the storage, which must outlive the task.
+ */
+struct static_task_params {
+  Priority priority;
+  const char* name;
+  void* tcb;
+  std::uint8_t* stack;
+  std::uint32_t stack_size;
+};
+
 /**
  * @brief Entrypoint to the kernel. User API must use these
  *        functions to interface with the kernel. This can be
  *        seen as the public API for the kernel.
+ *
+ * The interface is only abstract in unit tests, so that the kernel can
+ * be mocked. Production builds call the Kernel directly, see
+ * SyscallImpl.
  */
 class ISyscall {
  public:
@@ -66,46 +98,80 @@ class ISyscall {
    * @param stack_size Size in bytes for the stack that will be allocated
    *                   for the newly created task.
    */
-  virtual void CreateTask(task_func func, void* arg, Priority priority,
-                          const char* name, std::uint32_t stack_size) = 0;
+  TEST_VIRTUAL void CreateTask(task_func func, void* arg, Priority priority,
+                               const char* name,
+                               std::uint32_t stack_size) TEST_PURE;
+
+  /**
+   * @brief Creates a new task without allocating memory and adds it
+   *        to the ready list.
+   * @param func Task function that will run when the task is scheduled.
+   * @param arg Argument for the task.
+   * @param params Storage for the task control block and the stack.
+   *               Priority and name are used as in CreateTask.
+   */
+  TEST_VIRTUAL void CreateTaskStatic(task_func func, void* arg,
+                                     const static_task_params& params)
+                                     TEST_PURE;
+
+  /**
+   * @brief Creates a new periodic task and adds it to the ready list.
+   *        Its first job is released right away.
+   * @param func Task function that will run when the task is scheduled.
+   *             It is expected to loop, calling WaitForNextPeriod()
+   *             at the end of every job.
+   * @param arg Argument for the task.
+   * @param params Period and deadline, in ticks. A deadline of 0 makes
+   *               it equal to the period. Priority, name and stack
+   *               size are used as in CreateTask.
+   */
+  TEST_VIRTUAL void CreatePeriodicTask(task_func func, void* arg,
+                                       const periodic_task_params& params)
+                                       TEST_PURE;
+
+  /**
+   * @brief Ends the current job of a periodic task, sleeping until the
+   *        next one is released. Returns right away if it already was.
+   */
+  TEST_VIRTUAL void WaitForNextPeriod() TEST_PURE;
 
   /**
    * @brief Removes the task from the ready list. It will stop the task
    *        and free all associated resources
    */
-  virtual void DestroyTask() = 0;
+  TEST_VIRTUAL void DestroyTask() TEST_PURE;
 
   /**
    * @brief Sleep the current task for the specified number of ticks.
    * @param ticks Number of ticks for which the task should be asleep
    *              and not scheduled to run by the kernel.
    */
-  virtual void Sleep(std::uint32_t ticks) = 0;
+  TEST_VIRTUAL void Sleep(std::uint32_t ticks) TEST_PURE;
 
   /**
    * @brief Starts the scheduler operation. This function is not
    *        expected to return. When called, the system will start
    *        scheduling tasks or run the Idle task if none were created.
    */
-  virtual void StartOS() = 0;
+  TEST_VIRTUAL void StartOS() TEST_PURE;
 
   /**
    * @brief Asks the scheduler to perform the scheduling and start running
    *        the task with the largest priority in the ready state.
    */
-  virtual void Yield() = 0;
+  TEST_VIRTUAL void Yield() TEST_PURE;
 
   /**
    * @brief Informs the kernel of an error in userspace.
    */
-  virtual void RegisterError() = 0;
+  TEST_VIRTUAL void RegisterError() TEST_PURE;
 
   /**
    * @brief Informs the kernel when a lockable resource is acquired/released.
    * @param lockable the locked/unlocked resource.
    * @param acquired true if it was acquried, false otherwise.
    */
-  virtual void Lock(Lockable& lockable, bool acquired) = 0; // NOLINT
+  TEST_VIRTUAL void Lock(Lockable& lockable, bool acquired) TEST_PURE; // NOLINT
 
   /**
    * @brief Called by a lockable resource when a task blocks
@@ -113,8 +179,19 @@ class ISyscall {
    * @param lockable the reference to the lockable resource
    *                 that originated the syscall
    */
-  virtual void Wait(const Lockable& lockable) = 0;
+  TEST_VIRTUAL void Wait(Lockable& lockable) TEST_PURE; // NOLINT
 };
+
+class Kernel;
+
+/**
+ * @brief Type the system calls are dispatched to.
+ */
+#ifdef UNITTEST
+using SyscallImpl = ISyscall;
+#else
+using SyscallImpl = Kernel;
+#endif
 }  // namespace Popcorn
 
 #endif  // POPCORN_API_ISYSCALL_H_
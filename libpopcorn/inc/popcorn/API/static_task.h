@@ -0,0 +1,70 @@
+/*
+ * This file is part of Popcorn
+ * Copyright (c) 2020 Javier Alvarez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POPCORN_API_STATIC_TASK_H_
+#define POPCORN_API_STATIC_TASK_H_
+
+#include <cstdint>
+
+#include "popcorn/API/isyscall.h"
+#include "popcorn/API/syscall.h"
+#include "popcorn/core/task_control_block.h"
+#include "popcorn/os_config.h"
+
+namespace Popcorn {
+/**
+ * @brief Storage for a task that is created without using the heap.
+ *
+ * Declare it with static storage duration, so it is placed in .bss
+ * and its size is accounted for at link time:
+ *
+ *   static StaticTask<512> s_task;
+ *   s_task.Create(TaskFunc, nullptr, Priority::Level_1, "Task");
+ *
+ * @tparam kStackSize Size of the task stack in bytes.
+ */
+template<std::uint32_t kStackSize>
+class StaticTask {
+ public:
+  static_assert(kStackSize >= MINIMUM_TASK_STACK_SIZE,
+                "The stack is smaller than MINIMUM_TASK_STACK_SIZE");
+  static_assert(kStackSize % 8 == 0,
+                "The stack size must keep the stack 8 byte aligned");
+
+  /**
+   * @brief Describes the storage for CreateTaskStatic.
+   */
+  static_task_params Params(Priority priority, const char* name) {
+    return { priority, name, m_tcb, m_stack, kStackSize };
+  }
+
+  /**
+   * @brief Creates the task on this storage through the Syscall API.
+   */
+  void Create(task_func func, void* arg, Priority priority,
+              const char* name) {
+    Syscall::Instance().CreateTaskStatic(func, arg, Params(priority, name));
+  }
+
+ private:
+  alignas(task_control_block) std::uint8_t
+    m_tcb[sizeof(task_control_block)];
+  alignas(8) std::uint8_t m_stack[kStackSize];
+};
+}  // namespace Popcorn
+
+#endif  // POPCORN_API_STATIC_TASK_H_
@@ -41,45 +41,76 @@ class Syscall : private ISyscall {
    *                   for the newly created task.
    */
   void CreateTask(task_func func, void* arg, Priority priority,
-                  const char* name, std::uint32_t stack_size) override;
+                  const char* name, std::uint32_t stack_size) TEST_OVERRIDE;
+
+  /**
+   * @brief Creates a new task without allocating memory and adds it
+   *        to the ready list.
+   * @param func Task function that will run when the task is scheduled.
+   * @param arg Argument for the task.
+   * @param params Storage for the task control block and the stack.
+   *               Priority and name are used as in CreateTask.
+   */
+  void CreateTaskStatic(task_func func, void* arg,
+                        const static_task_params& params) TEST_OVERRIDE;
+
+  /**
+   * @brief Creates a new periodic task and adds it to the ready list.
+   *        Its first job is released right away.
+   * @param func Task function that will run when the task is scheduled.
+   *             It is expected to loop, calling WaitForNextPeriod()
+   *             at the end of every job.
+   * @param arg Argument for the task.
+   * @param params Period and deadline, in ticks. A deadline of 0 makes
+   *               it equal to the period. Priority, name and stack
+   *               size are used as in CreateTask.
+   */
+  void CreatePeriodicTask(task_func func, void* arg,
+                          const periodic_task_params& params) TEST_OVERRIDE;
+
+  /**
+   * @brief Ends the current job of a periodic task, sleeping until the
+   *        next one is released. Returns right away if it already was.
+   */
+  void WaitForNextPeriod() TEST_OVERRIDE;
 
   /**
    * @brief Removes the task from the ready list. It will stop the task
    *        and free all associated resources
    */
-  void DestroyTask() override;
+  void DestroyTask() TEST_OVERRIDE;
 
   /**
    * @brief Sleep the current task for the specified number of ticks.
    * @param ticks Number of ticks for which the task should be asleep
    *              and not scheduled to run by the kernel.
    */
-  void Sleep(std::uint32_t ticks) override;
+  void Sleep(std::uint32_t ticks) TEST_OVERRIDE;
 
   /**
    * @brief Starts the scheduler operation. This function is not
    *        expected to return. When called, the system will start
    *        scheduling tasks or run the Idle task if none were created.
    */
-  void StartOS() override;
+  void StartOS() TEST_OVERRIDE;
 
   /**
    * @brief Asks the scheduler to perform the scheduling and start running
    *        the task with the largest priority in the ready state.
    */
-  void Yield() override;
+  void Yield() TEST_OVERRIDE;
 
   /**
    * @brief Informs the kernel of an error in userspace.
    */
-  void RegisterError() override;
+  void RegisterError() TEST_OVERRIDE;
 
   /**
    * @brief Informs the kernel when a lockable resource is acquired/released.
    * @param lockable the locked/unlocked resource.
    * @param acquired true if it was acquried, false otherwise.
    */
-  void Lock(Lockable& lockable, bool acquired) override;
+  void Lock(Lockable& lockable, bool acquired) TEST_OVERRIDE;
 
   /**
    * @brief Obtains the singleton instance of the Syscall class.
@@ -110,7 +141,7 @@ class Syscall : private ISyscall {
    * Should only be called internally by the Lockable class,
    * which is the reason why it is declared private
    */
-  void Wait(const Lockable& lockable) override;
+  void Wait(Lockable& lockable) TEST_OVERRIDE;
 
   /**
    * @brief The Lockable class needs to be declared as a friend
@@ -0,0 +1,135 @@
+/*
+ * This file is part of Popcorn
+ * Copyright (c) 2020 Javier Alvarez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POPCORN_API_SYSTEM_H_
+#define POPCORN_API_SYSTEM_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+#include "popcorn/API/isyscall.h"
+#include "popcorn/API/syscall.h"
+#include "popcorn/core/kernel.h"
+#include "popcorn/core/task_control_block.h"
+#include "popcorn/os_config.h"
+
+namespace Popcorn {
+extern Kernel* g_kernel;
+
+/**
+ * @brief Entry of the task table of a System.
+ */
+struct task_description {
+  task_func func;
+  void* arg;
+  Priority priority;
+  const char* name;
+  std::uint32_t stack_size;
+};
+
+/**
+ * @brief Whole system built from a constexpr task table.
+ *
+ * The storage of every task control block and stack is laid out at
+ * compile time, and the tasks are made ready before the scheduler
+ * starts, without system calls or heap allocations:
+ *
+ *   constexpr Popcorn::task_description kTasks[] = {
+ *     { TaskFunc, nullptr, Popcorn::Priority::Level_1, "Task", 512 },
+ *   };
+ *   static Popcorn::System<kTasks> s_system;
+ *   s_system.Start();
+ *
+ * @tparam kTasks The task table. Stack sizes are rounded up to keep
+ *                stacks 8 byte aligned and to MINIMUM_TASK_STACK_SIZE.
+ */
+template<const auto& kTasks>
+class System {
+ public:
+  static constexpr std::size_t kNumTasks = std::size(kTasks);
+
+  /**
+   * @brief Makes every task ready. Must be called before the
+   *        scheduler starts, from privileged thread mode.
+   */
+  void CreateTasks(Kernel* kernel) {
+    for (std::size_t i = 0; i < kNumTasks; i++) {
+      const task_description& task = kTasks[i];
+      static_task_params params = {
+        task.priority,
+        task.name,
+        &m_tcbs[i],
+        &m_stacks[kStackOffsets[i]],
+        StackSize(task)
+      };
+      kernel->CreateTaskStatic(task.func, task.arg, params);
+    }
+  }
+
+  /**
+   * @brief Creates the tasks and starts the scheduler. This function
+   *        is not expected to return.
+   */
+  void Start() {
+    // Instantiates the kernel
+    auto& syscall = Syscall::Instance();
+    CreateTasks(g_kernel);
+    syscall.StartOS();
+  }
+
+ private:
+  static constexpr std::uint32_t StackSize(const task_description& task) {
+    std::uint32_t size = (task.stack_size + 7U) & ~7U;
+    return size < MINIMUM_TASK_STACK_SIZE ? MINIMUM_TASK_STACK_SIZE : size;
+  }
+
+  static constexpr std::array<std::size_t, kNumTasks + 1> StackOffsets() {
+    std::array<std::size_t, kNumTasks + 1> offsets = {};
+    for (std::size_t i = 0; i < kNumTasks; i++) {
+      offsets[i + 1] = offsets[i] + StackSize(kTasks[i]);
+    }
+    return offsets;
+  }
+
+  static constexpr bool IsValid() {
+    for (const task_description& task : kTasks) {
+      if ((task.func == nullptr) || (task.priority == Priority::IDLE)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static_assert(kNumTasks > 0, "The task table is empty");
+  static_assert(IsValid(),
+                "Every task needs a function and a priority above IDLE");
+
+  static constexpr auto kStackOffsets = StackOffsets();
+
+  struct tcb_storage {
+    alignas(task_control_block) std::uint8_t
+      bytes[sizeof(task_control_block)];
+  };
+
+  tcb_storage m_tcbs[kNumTasks];
+  alignas(8) std::uint8_t m_stacks[kStackOffsets[kNumTasks]];
+};
+}  // namespace Popcorn
+
+#endif  // POPCORN_API_SYSTEM_H_
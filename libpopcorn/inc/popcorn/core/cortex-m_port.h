@@ -25,12 +25,8 @@
 #include "popcorn/core/syscall_idx.h"
 #include "popcorn/core/kernel.h"
 
-#ifndef UNITTEST
-#define _SVC_CALL(x) asm volatile("svc %[opcode]" \
-                     :: [opcode] "i" (static_cast<uint32_t>(x)));
-#else
+#ifdef UNITTEST
 void _svc_call(Popcorn::SyscallIdx id);
-#define _SVC_CALL(x) _svc_call(x)
 #endif
 
 #define EXC_RETURN_PSP_UNPRIV       (0xFFFFFFFDU)
@@ -56,6 +52,18 @@ struct auto_task_stack_frame {
   std::uint32_t xpsr;
 };
 
+/**
+ * @brief Arguments of the CreateTask system call, which do not fit
+ *        in registers. Passed by pointer in r0.
+ */
+struct create_task_args {
+  Popcorn::task_func func;
+  void* arg;
+  Popcorn::Priority priority;
+  const char* name;
+  std::uint32_t stack_size;
+};
+
 /**
  * @brief Manually saved task stack frame upon exception entry.
  *        These are the registers that are saved by the callee
@@ -88,33 +96,103 @@ struct task_stack_frame {
 class MCU {
  public:
   MCU();
-  TEST_VIRTUAL void RegisterSyscallImpl(Popcorn::ISyscall* syscall_impl);
+  TEST_VIRTUAL void RegisterSyscallImpl(Popcorn::SyscallImpl* syscall_impl);
   TEST_VIRTUAL void Initialize() const;
 
+  /**
+   * @brief Enters the kernel. The number of the system call is passed
+   *        in r12 and its arguments in r0 to r2. Calls taking more
+   *        arguments pass a pointer to them.
+   */
   template<Popcorn::SyscallIdx id>
-  static void SupervisorCall() {
-    _SVC_CALL(id);
+  static void SupervisorCall(std::uintptr_t arg0 = 0,
+                             std::uintptr_t arg1 = 0,
+                             std::uintptr_t arg2 = 0) {
+#ifndef UNITTEST
+    register std::uintptr_t r0 asm("r0") = arg0;
+    register std::uintptr_t r1 asm("r1") = arg1;
+    register std::uintptr_t r2 asm("r2") = arg2;
+    register std::uintptr_t r12 asm("r12") = static_cast<std::uintptr_t>(id);
+    asm volatile("svc #0"
+                 :: "r" (r0), "r" (r1), "r" (r2), "r" (r12)
+                 : "memory");
+#else
+    _svc_call(id);
+#endif
   }
   TEST_VIRTUAL void TriggerPendSV() const;
   TEST_VIRTUAL void DisableInterrupts();
   TEST_VIRTUAL void EnableInterrupts();
 
+  /**
+   * @brief Stops the periodic tick and programs the timer to expire
+   *        after the given number of ticks instead.
+   * @param ticks Number of ticks to suppress. Clamped to the longest
+   *              period the timer can count.
+   * @return The number of ticks actually suppressed. 0 if the periodic
+   *         tick was left untouched.
+   */
+  TEST_VIRTUAL std::uint32_t SuppressTicks(std::uint32_t ticks);
+
+  /**
+   * @brief Restores the periodic tick after SuppressTicks.
+   * @return The number of ticks elapsed while the tick was suppressed.
+   */
+  TEST_VIRTUAL std::uint32_t RestoreTicks();
+
+  /**
+   * @brief Puts the core to sleep until the next interrupt.
+   */
+  static void WaitForInterrupt();
+
   TEST_VIRTUAL uint8_t* InitializeTask(uint8_t* stack_top,
                                        Popcorn::task_func func,
                                        void* arg) const;
 
+  /**
+   * @brief Fills the main stack below the current stack pointer with
+   *        STACK_FILL_PATTERN, to measure the stack used by exception
+   *        handlers. Must be called on the main stack.
+   * @param size Bytes to fill.
+   * @return Lowest address of the filled region.
+   */
+  TEST_VIRTUAL std::uint8_t* FillMainStack(std::uint32_t size);
+
+  /**
+   * @brief Moves the stack guard MPU region. Only used when
+   *        STACK_GUARD_SIZE is not 0.
+   * @param base Lowest address of the guard, aligned to
+   *             STACK_GUARD_SIZE.
+   */
+  TEST_VIRTUAL void SetStackGuard(std::uintptr_t base) const;
+
   TEST_VIRTUAL ~MCU() = default;
 
  private:
   TEST_VIRTUAL void HandleSVC(auto_task_stack_frame* args) const;
-  static void HandleSVC_Static(auto_task_stack_frame* args);
-  Popcorn::SyscallIdx GetSVCCode(const std::uint8_t* pc) const;
+
+  /**
+   * @brief Entry point of the SVC handler.
+   * @param from_task Whether the call was made from a task, on the
+   *                  process stack.
+   * @return true if the handler has to switch context before returning,
+   *         instead of leaving it to PendSV.
+   */
+  static bool HandleSVC_Static(auto_task_stack_frame* args, bool from_task);
+
+  /**
+   * @brief Clears a pending context switch request.
+   * @return Whether a context switch was requested.
+   */
+  bool TakePendingContextSwitch() const;
+
   TEST_VIRTUAL void DisableInterruptsInternal() const;
   TEST_VIRTUAL void EnableInterruptsInternal() const;
   TEST_VIRTUAL task_stack_frame* AllocateTaskStackFrame(uint8_t* stack_ptr) const;
 
-  Popcorn::ISyscall* m_syscall_impl;
+  Popcorn::SyscallImpl* m_syscall_impl;
   std::atomic_uint32_t m_nested_interrupt_level;
+  std::uint32_t m_suppressed_ticks;
 
   friend void ::SVC_Handler();
   friend class MCUTest;
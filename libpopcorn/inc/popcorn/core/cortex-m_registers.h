@@ -23,6 +23,8 @@
 namespace Hw {
 constexpr std::uint32_t SCB_CCR_STKALIGN = 1U << 9;
 constexpr std::uint32_t SCB_ICSR_PENDSVSET = 1U << 28;
+constexpr std::uint32_t SCB_ICSR_PENDSVCLR = 1U << 27;
+constexpr std::uint32_t SCB_ICSR_PENDSTSET = 1U << 26;
 
 constexpr std::uint32_t SYSTICK_SHP_IDX = 11;
 constexpr std::uint32_t PEND_SV_SHP_IDX = 10;
@@ -68,6 +70,28 @@ constexpr std::uint32_t SysTick_Ctrl_ClkSource        = (1UL <<  2U);
 constexpr std::uint32_t SysTick_Ctrl_TickInt          = (1UL <<  1U);
 constexpr std::uint32_t SysTick_Ctrl_Enable           = (1UL <<  0U);
 
+constexpr std::uint32_t SysTick_Load_Max              = 0x00FFFFFFUL;
+
+constexpr std::uint32_t MPU_ADDR = 0xE000ED90UL;
+struct MPU_t {
+  std::uint32_t TYPE;
+  std::uint32_t CTRL;
+  std::uint32_t RNR;
+  std::uint32_t RBAR;
+  std::uint32_t RASR;
+};
+extern volatile MPU_t *g_MPU;
+
+constexpr std::uint32_t MPU_Ctrl_PrivDefEna           = (1UL <<  2U);
+constexpr std::uint32_t MPU_Ctrl_Enable               = (1UL <<  0U);
+
+constexpr std::uint32_t MPU_Rbar_Valid                = (1UL <<  4U);
+
+constexpr std::uint32_t MPU_Rasr_XN                   = (1UL << 28U);
+constexpr std::uint32_t MPU_Rasr_AP_NoAccess          = (0UL << 24U);
+constexpr std::uint32_t MPU_Rasr_Size_Pos             = 1U;
+constexpr std::uint32_t MPU_Rasr_Enable               = (1UL <<  0U);
+
 }  // namespace Hw
 
 #endif  // POPCORN_CORE_CORTEX_M_REGISTERS_H_
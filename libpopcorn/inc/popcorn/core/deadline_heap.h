@@ -0,0 +1,134 @@
+/*
+ * This file is part of Popcorn
+ * Copyright (c) 2020 Javier Alvarez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POPCORN_CORE_DEADLINE_HEAP_H_
+#define POPCORN_CORE_DEADLINE_HEAP_H_
+
+#include <array>
+#include <cstddef>
+
+#include "popcorn/platform.h"
+
+namespace Popcorn {
+/**
+ * @brief Binary min-heap of tasks keyed on their absolute deadline.
+ *
+ * Tasks with equal deadlines are ordered by priority. Each task stores
+ * its position in the heap, so any task can be removed in O(log n).
+ * @tparam Task Task type, providing deadline, priority and heap_index.
+ * @tparam kCapacity Maximum number of tasks in the heap.
+ */
+template<typename Task, std::size_t kCapacity>
+class DeadlineHeap {
+ public:
+  /**
+   * @brief Adds a task to the heap.
+   * @param task The task, it must not be in the heap already.
+   */
+  void Push(Task* task) {
+    ATE_ASSERT(m_size < kCapacity);
+    Place(m_size, task);
+    SiftUp(m_size++);
+  }
+
+  /**
+   * @brief Removes a task from the heap.
+   * @param task The task, it must be in the heap.
+   */
+  void Remove(Task* task) {
+    std::size_t index = task->heap_index;
+    ATE_ASSERT((index < m_size) && (m_tasks[index] == task));
+
+    Task* last = m_tasks[--m_size];
+    if (index == m_size) {
+      return;
+    }
+
+    // The last task takes the place of the removed one and
+    // moves up or down to restore the heap property.
+    Place(index, last);
+    if ((index > 0) && Precedes(last, m_tasks[Parent(index)])) {
+      SiftUp(index);
+    } else {
+      SiftDown(index);
+    }
+  }
+
+  /**
+   * @brief Task with the earliest deadline.
+   * @return The task, or nullptr if the heap is empty.
+   */
+  Task* Top() const {
+    return (m_size > 0) ? m_tasks[0] : nullptr;
+  }
+
+  std::size_t Size() const {
+    return m_size;
+  }
+
+ private:
+  static bool Precedes(const Task* a, const Task* b) {
+    if (a->deadline != b->deadline) {
+      return a->deadline < b->deadline;
+    }
+    return a->priority > b->priority;
+  }
+
+  static constexpr std::size_t Parent(std::size_t index) {
+    return (index - 1) / 2;
+  }
+
+  void Place(std::size_t index, Task* task) {
+    m_tasks[index] = task;
+    task->heap_index = index;
+  }
+
+  void SiftUp(std::size_t index) {
+    Task* task = m_tasks[index];
+    while ((index > 0) && Precedes(task, m_tasks[Parent(index)])) {
+      Place(index, m_tasks[Parent(index)]);
+      index = Parent(index);
+    }
+    Place(index, task);
+  }
+
+  void SiftDown(std::size_t index) {
+    Task* task = m_tasks[index];
+    while (true) {
+      std::size_t child = 2 * index + 1;
+      if (child >= m_size) {
+        break;
+      }
+      if ((child + 1 < m_size) &&
+          Precedes(m_tasks[child + 1], m_tasks[child])) {
+        child++;
+      }
+      if (!Precedes(m_tasks[child], task)) {
+        break;
+      }
+      Place(index, m_tasks[child]);
+      index = child;
+    }
+    Place(index, task);
+  }
+
+  std::array<Task*, kCapacity> m_tasks = {};
+  std::size_t m_size = 0;
+};
+}  // namespace Popcorn
+
+#endif  // POPCORN_CORE_DEADLINE_HEAP_H_
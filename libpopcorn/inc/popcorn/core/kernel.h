@@ -20,6 +20,9 @@
 
 #include "popcorn/API/syscall.h"
 #include "popcorn/core/lockable.h"
+#include "popcorn/core/scheduling_policy.h"
+#include "popcorn/core/task_cache.h"
+#include "popcorn/core/task_control_block.h"
 #include "popcorn/utils/linked_list.h"
 #include "popcorn/platform.h"
 #include "popcorn/os_config.h"
@@ -34,48 +37,24 @@ CLINKAGE void SysTick_Handler();
 CLINKAGE void PendSV_Handler();
 
 namespace Popcorn {
-enum class task_state {
-  READY,
-  RUNNING,
-  SLEEPING,
-  BLOCKED
-};
-
-union block_argument {
-  std::uint64_t timestamp;
-  const Popcorn::Lockable* lockable;
-};
-
-struct task_control_block {
-  // Assembly code relies on the stack_ptr being at
-  // offset 0 from the task_control block
-  // DO NOT CHANGE!
-  std::uintptr_t                       stack_ptr;
-  std::uintptr_t                       arg;
-  task_func                            func;
-  uintptr_t                            stack_base;
-  LinkedList_t                         list;
-  Popcorn::Priority                         priority;
-  Popcorn::Priority                         base_priority;
-  task_state                           state;
-  char                                 name[MAX_TASK_NAME];
-  block_argument                       blockArgument;
-  std::uint64_t                        run_last_timestamp;
-};
-
 class Kernel : public ISyscall {
  public:
   explicit Kernel(Hw::MCU* mcu);
 
-  void StartOS() override;
+  void StartOS() TEST_OVERRIDE;
   void CreateTask(task_func func, void* arg, Popcorn::Priority priority,
-                  const char* name, std::uint32_t stack_size) override;
-  void Sleep(std::uint32_t ticks) override;
-  void DestroyTask() override;
-  void Yield() override;
-  void Wait(const Lockable& lockable) override;
-  void RegisterError() override;
-  void Lock(Lockable& lockable, bool acquired) override;
+                  const char* name, std::uint32_t stack_size) TEST_OVERRIDE;
+  void CreateTaskStatic(task_func func, void* arg,
+                        const static_task_params& params) TEST_OVERRIDE;
+  void CreatePeriodicTask(task_func func, void* arg,
+                          const periodic_task_params& params) TEST_OVERRIDE;
+  void WaitForNextPeriod() TEST_OVERRIDE;
+  void Sleep(std::uint32_t ticks) TEST_OVERRIDE;
+  void DestroyTask() TEST_OVERRIDE;
+  void Yield() TEST_OVERRIDE;
+  void Wait(Lockable& lockable) TEST_OVERRIDE;
+  void RegisterError() TEST_OVERRIDE;
+  void Lock(Lockable& lockable, bool acquired) TEST_OVERRIDE;
 
   TEST_VIRTUAL std::uint64_t GetTicks();
   TEST_VIRTUAL ~Kernel() = default;
@@ -84,6 +63,45 @@ class Kernel : public ISyscall {
     return m_current_task;
   }
 
+  /**
+   * @brief Number of context switches that were not requested because
+   *        the scheduler would have kept the running task.
+   */
+  std::uint32_t GetSkippedContextSwitches() const {
+    return m_skipped_context_switches;
+  }
+
+  /**
+   * @brief Deepest stack usage of a task so far, in bytes. Always 0
+   *        unless STACK_WATERMARK is enabled.
+   */
+  std::uint32_t GetStackHighWatermark(const task_control_block* tcb) const;
+
+  /**
+   * @brief Deepest stack usage of exception handlers so far, in bytes,
+   *        below the main stack pointer at StartOS. Always 0 unless
+   *        ISR_STACK_SIZE is set.
+   */
+  std::uint32_t GetIsrStackHighWatermark() const;
+
+  /**
+   * @brief Raises the running task to a ceiling priority. Tasks with
+   *        a priority up to the ceiling can not preempt it.
+   *
+   * Runs in thread mode inside a critical section instead of a
+   * system call. Tasks must not block while a ceiling is raised.
+   * @param ceiling The new ceiling, it is never lowered.
+   * @return The previous ceiling, to be passed to RestoreCeiling().
+   */
+  Priority RaiseCeiling(Priority ceiling);
+
+  /**
+   * @brief Restores the ceiling of the running task, requesting a
+   *        context switch if a task was kept from preempting it.
+   * @param ceiling The value returned by RaiseCeiling().
+   */
+  void RestoreCeiling(Priority ceiling);
+
  private:
   TEST_VIRTUAL void TriggerScheduler();
   TEST_VIRTUAL void HandleTick();
@@ -92,22 +110,113 @@ class Kernel : public ISyscall {
 
   TEST_VIRTUAL void CheckTaskNeedsAwakening();
 
-  TEST_VIRTUAL std::uint8_t* AllocateTaskStack(Popcorn::task_control_block *tcb,
-                                               std::size_t size) const;
+  /**
+   * @brief Transfers the ownership of a resource, keeping track
+   *        of the resources held by each task.
+   * @param lockable The resource.
+   * @param tcb The new owner, nullptr if the resource is freed.
+   */
+  void SetLockOwner(Lockable& lockable, task_control_block* tcb);
+
+  /**
+   * @brief Computes the priority a task should run at, the highest
+   *        between its base priority, its ceiling and the priority
+   *        of the top waiter of each resource it holds.
+   */
+  Priority GetInheritedPriority(const task_control_block* tcb) const;
+
+  /**
+   * @brief Updates the priority of a task after its waiters changed,
+   *        following the chain of blockers if the task is blocked.
+   */
+  void UpdateInheritedPriority(task_control_block* tcb);
+
+  /**
+   * @brief Triggers a context switch only if the scheduler would select
+   *        a task other than the running one.
+   * @param voluntary Whether the running task gives up the CPU. Under a
+   *                  non-preemptive policy only voluntary requests switch.
+   */
+  void RequestContextSwitch(bool voluntary = false);
+
+  /**
+   * @brief Stops the periodic tick until the next wake up if only the
+   *        Idle task is runnable. See TICKLESS_IDLE in os_config.h.
+   */
+  void EnterTicklessIdle();
+
+  /**
+   * @brief Restores the periodic tick if it was stopped, catching up
+   *        the tick count with the time spent idle.
+   * @return Number of ticks elapsed while idle.
+   */
+  std::uint32_t ExitTicklessIdle();
+
+  /**
+   * @brief Lets the scheduling policy account one tick to the running
+   *        task. A task holding a ceiling mutex is never rotated, its
+   *        peers might share the mutex.
+   */
+  void UpdateTimeSlice();
+
+  /**
+   * @brief Initializes a task on the given storage without making
+   *        it ready.
+   * @param memory Storage for the task control block.
+   * @param stack Lowest address of the task stack.
+   * @param stack_size Size of the stack in bytes.
+   * @return The new task.
+   */
+  task_control_block* ConstructTask(void* memory, std::uint8_t* stack,
+                                    std::size_t stack_size, task_func func,
+                                    void* arg, Priority priority,
+                                    const char* name);
+
+  /**
+   * @brief Allocates and initializes a task without making it ready.
+   *        Not available when DYNAMIC_TASK_ALLOCATION is disabled.
+   * @return The new task, or nullptr if it could not be allocated.
+   */
+  task_control_block* AllocateTask(task_func func, void* arg,
+                                   Priority priority, const char* name,
+                                   std::uint32_t stack_size);
+
+  /**
+   * @brief Sends a task, already taken out of the ready set, to the
+   *        sleeping list and requests a context switch.
+   * @param tcb The task.
+   * @param timestamp Tick at which the task is woken up.
+   */
+  void SleepUntil(task_control_block* tcb, std::uint64_t timestamp);
+
+  /**
+   * @brief Changes the priority of a task, moving it to the right
+   *        place in the ready set if it is currently runnable.
+   */
+  void SetTaskPriority(task_control_block* tcb, Priority priority);
 
   static void TriggerScheduler_Static();
 
   Hw::MCU*                    m_mcu           = nullptr;
   task_control_block*         m_current_task  = nullptr;
-  LinkedList_t*               m_ready_list    = nullptr;
-  LinkedList_t*               m_blocked_list  = nullptr;
-  LinkedList_t*               m_sleeping_list = nullptr;
+  Scheduler                   m_scheduler;
+  LinkedList<task_control_block> m_sleeping_list;
+  TaskCache<TASK_CACHE_SIZE>  m_task_cache;
 
   /**
    * @todo Use atomic for m_ticks instead of a regular uint64_t variable
    */
   std::uint64_t               m_ticks         = 0;
 
+  bool                        m_tickless_idle = TICKLESS_IDLE;
+  bool                        m_ticks_suppressed = false;
+
+  std::uint32_t               m_skipped_context_switches = 0;
+
+  // Bottom of the region of the main stack filled by StartOS
+  std::uint8_t*               m_isr_stack = nullptr;
+  std::uint32_t               m_isr_stack_size = 0;
+
   friend void ::SysTick_Handler();
   friend void ::PendSV_Handler();
   friend class ::KernelTest;
@@ -18,41 +18,94 @@
 #ifndef POPCORN_CORE_LOCKABLE_H_
 #define POPCORN_CORE_LOCKABLE_H_
 
+#include <atomic>
+#include <cstdint>
+
+#include "popcorn/utils/linked_list.h"
+
+class KernelTest;
+
 namespace Popcorn {
+struct task_control_block;
+
 /**
  * @brief Implements a basic lockable type.
  *
  * Use this as a parent class for mutex, semaphore,
  * queues and anything that can lock on a resource.
- * It is internally used to keep track of the blocked task
- * and perform priority inheritance.
+ * It is internally used to keep track of the blocked task,
+ * the tasks waiting for the resource and perform priority
+ * inheritance.
  */
 class Lockable {
+ public:
+  /**
+   * @brief Links the resource in the list of resources held
+   *        by its owner. Lockable is not a standard layout type,
+   *        so the node keeps a pointer back to the resource.
+   */
+  struct held_node {
+    ListNode list;
+    Lockable* lockable;
+  };
+
  protected:
+  /**
+   * @brief Tries to take the resource without the kernel.
+   *        Must be called from a task.
+   * @return true if the resource was free and is now held by
+   *         the running task.
+   */
+  bool TryAcquire();
+
+  /**
+   * @brief Tries to free the resource without the kernel.
+   * @return false if the kernel has to release it because tasks
+   *         are waiting for it, see LockReleased().
+   */
+  bool TryRelease();
+
   /**
    * @brief Blocks waiting for this resource
    *
    * Call from the child object when waiting for the
-   * resource to be available
+   * resource to be available. When it returns the resource
+   * has been handed over to the calling task by the kernel.
    */
   void Block();
 
   /**
    * @brief Inform the kernel about the acquired lock
    *
-   * Call from the child object when the locked resource
-   * has been acquired.
+   * Optional, the kernel learns about the owner on contention
+   * anyway. The resource has to be released through
+   * LockReleased() afterwards.
    */
   void LockAcquired();
 
   /**
    * @brief Inform the kernel about the released lock.
    *
-   * Call from the child object when the locked resource
-   * has been released.
+   * Call from the child object to release the locked
+   * resource. The kernel either hands it over to the
+   * highest priority waiter or marks it as free.
    */
   void LockReleased();
 
+  /**
+   * @brief Set in m_state while the kernel tracks the owner, which
+   *        is the case whenever tasks wait for the resource. Task
+   *        control blocks are aligned, so the bit is never part of
+   *        the owner address.
+   */
+  static constexpr std::uintptr_t kKernelOwnedBit = 1U;
+
+  /**
+   * @brief Address of the task holding the resource, 0 if free,
+   *        combined with kKernelOwnedBit.
+   */
+  std::atomic<std::uintptr_t> m_state = 0;
+
  private:
   /**
    * @brief Setter for m_blocker.
@@ -67,13 +120,22 @@ class Lockable {
    */
   struct task_control_block* GetBlockerTask() const;
 
-  struct task_control_block *m_blocker;
+  struct task_control_block *m_blocker = nullptr;
+
+  /**
+   * @brief Tasks waiting for this resource, ordered by priority.
+   *        Tasks of equal priority are kept in FIFO order.
+   */
+  LinkedList<task_control_block> m_waiters;
+
+  held_node m_held_node = { {}, this };
 
   /**
    * @brief The kernel needs to call private methods
    *        for priority inheritance reasons.
    */
   friend class Kernel;
+  friend class ::KernelTest;
 };
 }  // namespace Popcorn
 
@@ -0,0 +1,230 @@
+/*
+ * This file is part of Popcorn
+ * Copyright (c) 2020 Javier Alvarez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POPCORN_CORE_SCHEDULING_POLICY_H_
+#define POPCORN_CORE_SCHEDULING_POLICY_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "popcorn/core/deadline_heap.h"
+#include "popcorn/core/task_control_block.h"
+#include "popcorn/utils/linked_list.h"
+#include "popcorn/os_config.h"
+
+class KernelTest;
+
+namespace Popcorn {
+/*
+ * Scheduling policies keep track of the ready tasks and decide which
+ * one runs. The kernel uses the policy selected by SCHEDULING_POLICY
+ * with static dispatch, so only that policy is built. Every policy
+ * provides:
+ *  - kPreemptive: whether a task becoming ready can preempt the
+ *    running task, or it keeps the CPU until it blocks or yields.
+ *  - AddReadyTask() and RemoveReadyTask() to maintain the ready set.
+ *  - GetNextTask() returning the task that should run.
+ *  - IsOnlyIdleReady() telling if the Idle task is the only ready one.
+ *  - ConsumeTimeSlice() called on every tick for the running task.
+ */
+
+/**
+ * @brief Ready queue per priority level, plus a bitmap of the
+ *        populated levels. All operations take constant time.
+ * @tparam kTimeSlicing Rotate tasks of equal priority once the running
+ *                      one exhausts its slice from TIME_SLICE_TICKS.
+ * @tparam kPreemptiveScheduling Let higher priority tasks preempt the
+ *                               running task.
+ */
+template<bool kTimeSlicing, bool kPreemptiveScheduling>
+class PriorityPolicy {
+ public:
+  static constexpr bool kPreemptive = kPreemptiveScheduling;
+
+  /**
+   * @brief Appends the task to the ready queue of its priority level
+   *        and marks the level as populated in the ready bitmap.
+   *        The time slice of the task is reloaded.
+   */
+  void AddReadyTask(task_control_block* tcb) {
+    auto level = static_cast<std::size_t>(tcb->priority);
+    m_ready_lists[level].PushBack(tcb);
+    m_ready_bitmap |= PriorityMask(tcb->priority);
+    tcb->time_slice = TimeSlice(tcb->priority);
+  }
+
+  /**
+   * @brief Removes the task from the ready queue of its priority level.
+   *        The level is cleared from the ready bitmap once empty.
+   */
+  void RemoveReadyTask(task_control_block* tcb) {
+    auto level = static_cast<std::size_t>(tcb->priority);
+    m_ready_lists[level].Remove(tcb);
+    if (m_ready_lists[level].Empty()) {
+      m_ready_bitmap &= ~PriorityMask(tcb->priority);
+    }
+  }
+
+  /**
+   * @brief Finds the task at the head of the highest populated ready
+   *        queue. Takes constant time regardless of the number of tasks.
+   */
+  task_control_block* GetNextTask() const {
+    if (m_ready_bitmap == 0) {
+      return nullptr;
+    }
+
+    // The highest populated level is given by the most significant bit
+    // set in the ready bitmap. This compiles to a single CLZ instruction.
+    auto level = 31 - __builtin_clz(m_ready_bitmap);
+    return m_ready_lists[level].Front();
+  }
+
+  bool IsOnlyIdleReady() const {
+    return m_ready_bitmap == PriorityMask(Priority::IDLE);
+  }
+
+  /**
+   * @brief Consumes one tick of the running task time slice. Once the
+   *        slice expires the task is sent to the back of its ready queue.
+   */
+  void ConsumeTimeSlice(task_control_block* tcb) {
+    if (!kTimeSlicing || (TimeSlice(tcb->priority) == 0)) {
+      return;
+    }
+
+    if (--tcb->time_slice == 0) {
+      // Slice expired. Rotate only if there is a peer to run,
+      // otherwise just start a new slice.
+      auto level = static_cast<std::size_t>(tcb->priority);
+      const auto& ready_list = m_ready_lists[level];
+      if (ready_list.Front() != ready_list.Back()) {
+        RemoveReadyTask(tcb);
+        AddReadyTask(tcb);
+      } else {
+        tcb->time_slice = TimeSlice(tcb->priority);
+      }
+    }
+  }
+
+ private:
+  static constexpr std::size_t kNumPriorities =
+    static_cast<std::size_t>(Priority::Level_9) + 1;
+  static_assert(kNumPriorities <= 32,
+                "The ready bitmap needs one bit per priority level");
+  static_assert(sizeof(TIME_SLICE_TICKS) / sizeof(TIME_SLICE_TICKS[0]) ==
+                kNumPriorities,
+                "A time slice must be configured for every priority level");
+
+  static constexpr std::uint32_t PriorityMask(Priority priority) {
+    return 1U << static_cast<std::uint32_t>(priority);
+  }
+
+  static constexpr std::uint32_t TimeSlice(Priority priority) {
+    return TIME_SLICE_TICKS[static_cast<std::size_t>(priority)];
+  }
+
+  LinkedList<task_control_block> m_ready_lists[kNumPriorities];
+  std::uint32_t               m_ready_bitmap  = 0;
+
+  friend class ::KernelTest;
+};
+
+/**
+ * @brief Preemptive fixed priority scheduling. Tasks of equal
+ *        priority run in FIFO order until they block or yield.
+ */
+using FixedPriorityPolicy = PriorityPolicy<false, true>;
+
+/**
+ * @brief Preemptive fixed priority scheduling with round-robin
+ *        time slicing among tasks of equal priority.
+ */
+using RoundRobinPolicy = PriorityPolicy<true, true>;
+
+/**
+ * @brief Cooperative scheduling. The running task is never preempted,
+ *        the highest priority ready task runs when it blocks or yields.
+ */
+using CooperativePolicy = PriorityPolicy<false, false>;
+
+/**
+ * @brief Preemptive earliest deadline first scheduling. Ready tasks
+ *        are kept in a heap ordered by absolute deadline.
+ */
+class EarliestDeadlineFirstPolicy {
+ public:
+  static constexpr bool kPreemptive = true;
+
+  void AddReadyTask(task_control_block* tcb) {
+    m_deadline_heap.Push(tcb);
+  }
+
+  void RemoveReadyTask(task_control_block* tcb) {
+    m_deadline_heap.Remove(tcb);
+  }
+
+  task_control_block* GetNextTask() const {
+    return m_deadline_heap.Top();
+  }
+
+  bool IsOnlyIdleReady() const {
+    return m_deadline_heap.Size() == 1;
+  }
+
+  void ConsumeTimeSlice(task_control_block* tcb) {
+    // Deadlines, not time slices, decide who runs
+    (void)tcb;
+  }
+
+ private:
+  DeadlineHeap<task_control_block, EDF_MAX_READY_TASKS> m_deadline_heap;
+};
+
+/**
+ * @brief Maps the SchedulingPolicy configuration to its policy class.
+ */
+template<SchedulingPolicy kPolicy>
+struct SchedulingPolicyClass;
+
+template<>
+struct SchedulingPolicyClass<SchedulingPolicy::FIXED_PRIORITY> {
+  using type = FixedPriorityPolicy;
+};
+
+template<>
+struct SchedulingPolicyClass<SchedulingPolicy::ROUND_ROBIN> {
+  using type = RoundRobinPolicy;
+};
+
+template<>
+struct SchedulingPolicyClass<SchedulingPolicy::EARLIEST_DEADLINE_FIRST> {
+  using type = EarliestDeadlineFirstPolicy;
+};
+
+template<>
+struct SchedulingPolicyClass<SchedulingPolicy::COOPERATIVE> {
+  using type = CooperativePolicy;
+};
+
+/**
+ * @brief Scheduling policy used by the kernel in this build.
+ */
+using Scheduler = SchedulingPolicyClass<SCHEDULING_POLICY>::type;
+}  // namespace Popcorn
+
+#endif  // POPCORN_CORE_SCHEDULING_POLICY_H_
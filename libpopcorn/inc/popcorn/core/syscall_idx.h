@@ -18,6 +18,8 @@
 #ifndef POPCORN_CORE_SYSCALL_IDX_H_
 #define POPCORN_CORE_SYSCALL_IDX_H_
 
+#include <cstddef>
+
 namespace Popcorn {
 enum class SyscallIdx {
   StartOS,
@@ -27,8 +29,15 @@ enum class SyscallIdx {
   Yield,
   Wait,
   RegisterError,
-  Lock
+  Lock,
+  CreatePeriodicTask,
+  WaitForNextPeriod,
+  CreateTaskStatic
 };
+
+// Size of the dispatch table. Update it when appending a system call.
+constexpr std::size_t NUM_SYSCALLS =
+  static_cast<std::size_t>(SyscallIdx::CreateTaskStatic) + 1;
 }  // namespace Popcorn
 
 #endif  // POPCORN_CORE_SYSCALL_IDX_H_
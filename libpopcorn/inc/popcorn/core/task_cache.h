@@ -0,0 +1,87 @@
+/*
+ * This file is part of Popcorn
+ * Copyright (c) 2020 Javier Alvarez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POPCORN_CORE_TASK_CACHE_H_
+#define POPCORN_CORE_TASK_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "popcorn/core/task_control_block.h"
+#include "popcorn/utils/linked_list.h"
+
+namespace Popcorn {
+/**
+ * @brief Keeps the control block and stack of destroyed tasks, so that
+ *        new tasks with the same stack size can be created without
+ *        going through the heap.
+ *
+ * Tasks are matched by stack size. Lookups scan at most kCapacity
+ * entries, so they take bounded time.
+ * @tparam kCapacity Maximum number of parked tasks. 0 disables the cache.
+ */
+template<std::size_t kCapacity>
+class TaskCache {
+ public:
+  /**
+   * @brief Parks a destroyed task. The task must not be linked in
+   *        any other list.
+   * @return Whether the task was parked. Otherwise the caller must
+   *         release its storage.
+   */
+  bool Park(task_control_block* tcb) {
+    if (m_size >= kCapacity) {
+      return false;
+    }
+
+    // The most recently parked task is reused first
+    m_tasks.PushFront(tcb);
+    m_size++;
+    return true;
+  }
+
+  /**
+   * @brief Takes a parked task out of the cache.
+   * @return A task with exactly stack_size bytes of stack, nullptr if
+   *         there is none.
+   */
+  task_control_block* Take(std::uint32_t stack_size) {
+    if constexpr (kCapacity == 0) {
+      return nullptr;
+    }
+
+    for (task_control_block* tcb : m_tasks) {
+      if (tcb->stack_size == stack_size) {
+        m_tasks.Remove(tcb);
+        m_size--;
+        return tcb;
+      }
+    }
+    return nullptr;
+  }
+
+  std::size_t Size() const {
+    return m_size;
+  }
+
+ private:
+  LinkedList<task_control_block> m_tasks;
+  std::size_t m_size = 0;
+};
+}  // namespace Popcorn
+
+#endif  // POPCORN_CORE_TASK_CACHE_H_
@@ -0,0 +1,69 @@
+/*
+ * This file is part of Popcorn
+ * Copyright (c) 2020 Javier Alvarez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POPCORN_CORE_TASK_CONTROL_BLOCK_H_
+#define POPCORN_CORE_TASK_CONTROL_BLOCK_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "popcorn/API/isyscall.h"
+#include "popcorn/core/lockable.h"
+#include "popcorn/utils/linked_list.h"
+#include "popcorn/os_config.h"
+
+namespace Popcorn {
+enum class task_state {
+  READY,
+  RUNNING,
+  SLEEPING,
+  BLOCKED
+};
+
+union block_argument {
+  std::uint64_t timestamp;
+  Popcorn::Lockable* lockable;
+};
+
+struct task_control_block {
+  // Assembly code relies on the stack_ptr being at
+  // offset 0 from the task_control block
+  // DO NOT CHANGE!
+  std::uintptr_t                       stack_ptr;
+  std::uintptr_t                       arg;
+  task_func                            func;
+  uintptr_t                            stack_base;
+  std::uint32_t                        stack_size;
+  uintptr_t                            stack_guard;
+  ListNode                             list;
+  Popcorn::Priority                         priority;
+  Popcorn::Priority                         base_priority;
+  task_state                           state;
+  char                                 name[MAX_TASK_NAME];
+  block_argument                       blockArgument;
+  std::uint32_t                        time_slice;
+  LinkedList<Lockable::held_node>      held_locks;
+  Popcorn::Priority                    ceiling;
+  std::uint64_t                        deadline;
+  std::uint32_t                        period;
+  std::uint32_t                        relative_deadline;
+  std::size_t                          heap_index;
+  bool                                 static_storage;
+};
+}  // namespace Popcorn
+
+#endif  // POPCORN_CORE_TASK_CONTROL_BLOCK_H_
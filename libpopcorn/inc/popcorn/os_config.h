@@ -23,7 +23,123 @@
 constexpr std::uint32_t MINIMUM_TASK_STACK_SIZE = 256;
 constexpr std::uint32_t MAX_TASK_NAME = 10;
 
+// When disabled, the kernel never uses the heap. Tasks, including the
+// Idle task, must be created with CreateTaskStatic from storage placed
+// in .bss (see StaticTask), and malloc is not linked in.
+constexpr bool DYNAMIC_TASK_ALLOCATION = true;
+
+// Number of destroyed tasks whose control block and stack are kept to
+// be reused by CreateTask, which then skips the heap entirely when a
+// task of the same stack size is available. Parked tasks keep their
+// memory, so it is disabled by default.
+constexpr std::uint32_t TASK_CACHE_SIZE = 0;
+
+// When enabled, task stacks are filled with a known pattern when the
+// task is created, so that Kernel::GetStackHighWatermark can tell the
+// deepest point each stack has reached.
+constexpr bool STACK_WATERMARK = true;
+
+// Bytes of main stack used by exception handlers, below the stack
+// pointer at StartOS. When not 0, they are filled with a known pattern
+// so that Kernel::GetIsrStackHighWatermark can measure them. It must not
+// exceed the main stack reserved by the linker script.
+constexpr std::uint32_t ISR_STACK_SIZE = 0;
+
+// Size in bytes of the no-access MPU region placed at the bottom of the
+// stack of the running task, so that an overflow faults instead of
+// corrupting the memory below. The region is moved on every context
+// switch. It must be a power of two of at least 32 bytes, and the
+// bottom STACK_GUARD_SIZE to 2 * STACK_GUARD_SIZE - 8 bytes of every
+// stack are given up to it. 0 leaves the MPU disabled.
+constexpr std::uint32_t STACK_GUARD_SIZE = 0;
+
+// Size classes of the block pools behind OsMalloc, in ascending order
+// of block size. Allocations take the smallest free block that fits.
+// Block sizes must be multiples of 8 to keep stacks aligned.
+struct memory_pool_class {
+  std::uint32_t block_size;
+  std::uint32_t num_blocks;
+};
+constexpr memory_pool_class MEMORY_POOL_CLASSES[] = {
+  { 64, 8 },     // Kernel objects
+  { 128, 8 },    // Task control blocks
+  { 256, 4 },    // Minimum task stacks
+  { 512, 4 },
+  { 1024, 2 },
+};
+
+// Backend of OsMalloc and OsFree.
+//  - BLOCK_POOLS: blocks from MEMORY_POOL_CLASSES. Allocations are
+//    rounded up to the size class and cannot fragment the heap.
+//    Aligned allocations are limited to 8 bytes.
+//  - TLSF: Two-Level Segregated Fit heap of TLSF_HEAP_SIZE bytes.
+//    Variable sized allocations in constant time.
+enum class MemoryAllocator {
+  BLOCK_POOLS,
+  TLSF
+};
+constexpr MemoryAllocator MEMORY_ALLOCATOR = MemoryAllocator::BLOCK_POOLS;
+constexpr std::uint32_t TLSF_HEAP_SIZE = 8192;
+
+// Instrumentation of the heap. Both options compile out completely
+// when disabled.
+//  - HEAP_STATISTICS: bytes in use and high watermark, reported by
+//    OsGetHeapStatistics along with the free memory of the heap.
+//  - HEAP_LEAK_TRACKING: tags every allocation with its owner task and
+//    allocation site, at a cost of a few words per allocation. Enables
+//    OsGetHeapUsage, and reports the allocations a task still owns when
+//    it is destroyed through App_HeapLeak_Hook.
+constexpr bool HEAP_STATISTICS = false;
+constexpr bool HEAP_LEAK_TRACKING = false;
+
 constexpr std::uint32_t SYSTICK_SRC_CLK_FREQ_HZ = 72'000'000;
 constexpr std::uint32_t TICK_FREQ_HZ = 1'000;
 
+// When enabled, the periodic tick is stopped while only the Idle task is
+// runnable and the timer is programmed to fire on the next wake up.
+// Note that tick hooks (App_SysTick_Hook) are then called once per idle
+// period instead of once per tick.
+constexpr bool TICKLESS_IDLE = false;
+
+// Round-robin time slice, in ticks, for each priority level, starting
+// at the Idle level, used by the ROUND_ROBIN policy. Tasks of equal
+// priority are rotated only once the running task exhausts its slice.
+// A slice of 0 disables time slicing for that level, making it run to
+// completion (or until it blocks).
+constexpr std::uint32_t TIME_SLICE_TICKS[] = {
+  0,   // IDLE
+  10,  // Level_0
+  10,  // Level_1
+  10,  // Level_2
+  10,  // Level_3
+  10,  // Level_4
+  10,  // Level_5
+  10,  // Level_6
+  10,  // Level_7
+  10,  // Level_8
+  10,  // Level_9
+};
+
+// Policy used to select the next task to run.
+//  - FIXED_PRIORITY: the highest priority ready task runs. Tasks of
+//    equal priority run in FIFO order until they block or yield.
+//  - ROUND_ROBIN: as FIXED_PRIORITY, but tasks of equal priority
+//    share the CPU according to TIME_SLICE_TICKS.
+//  - EARLIEST_DEADLINE_FIRST: the ready task with the earliest absolute
+//    deadline runs, using the priority to break ties. Tasks created
+//    without a deadline run by priority after all periodic tasks.
+//  - COOPERATIVE: the running task is never preempted. The highest
+//    priority ready task runs once it blocks or yields.
+enum class SchedulingPolicy {
+  FIXED_PRIORITY,
+  ROUND_ROBIN,
+  EARLIEST_DEADLINE_FIRST,
+  COOPERATIVE
+};
+constexpr SchedulingPolicy SCHEDULING_POLICY = SchedulingPolicy::ROUND_ROBIN;
+
+// Maximum number of tasks that can be ready at the same time, including
+// the Idle task, when using the EARLIEST_DEADLINE_FIRST policy.
+constexpr std::uint32_t EDF_MAX_READY_TASKS = 16;
+
 #endif  // POPCORN_OS_CONFIG_H_
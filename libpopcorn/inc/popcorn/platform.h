@@ -41,10 +41,16 @@ void AteAssertFailed(std::uintptr_t PC);
                                     }
 #endif
 
+// Virtual dispatch is only kept in unit tests, where it allows mocking.
+// Production builds bind calls statically.
 #ifdef UNITTEST
 #define TEST_VIRTUAL virtual
+#define TEST_OVERRIDE override
+#define TEST_PURE = 0
 #else
 #define TEST_VIRTUAL
+#define TEST_OVERRIDE
+#define TEST_PURE
 #endif
 
 #endif  // POPCORN_PLATFORM_H_
@@ -0,0 +1,65 @@
+/*
+ * This file is part of Popcorn
+ * Copyright (c) 2020 Javier Alvarez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POPCORN_PRIMITIVES_CEILING_MUTEX_H_
+#define POPCORN_PRIMITIVES_CEILING_MUTEX_H_
+
+#include "popcorn/core/kernel.h"
+
+namespace Popcorn {
+extern Kernel* g_kernel;
+
+/**
+ * @brief Mutex implementing the immediate priority ceiling protocol.
+ *
+ * The holder runs at the ceiling priority, so no other user of the
+ * mutex can run while it is held. Locking never blocks and does not
+ * need a system call.
+ *
+ * The ceiling must be at least the priority of every task using the
+ * mutex and tasks must not block while holding it.
+ * @tparam kCeiling The ceiling priority.
+ */
+template<Priority kCeiling>
+class CeilingMutex {
+ public:
+  void Lock() {
+    m_saved_ceiling = g_kernel->RaiseCeiling(kCeiling);
+  }
+
+  void Unlock() {
+    g_kernel->RestoreCeiling(m_saved_ceiling);
+  }
+
+  /**
+   * @brief Checks that the ceiling covers a set of user priorities.
+   *
+   * Intended for static_assert on the tasks sharing the mutex, e.g.
+   * static_assert(CeilingMutex<Priority::Level_3>::Covers(
+   *   Priority::Level_1, Priority::Level_3));
+   */
+  template<typename... Priorities>
+  static constexpr bool Covers(Priorities... priorities) {
+    return ((priorities <= kCeiling) && ...);
+  }
+
+ private:
+  Priority m_saved_ceiling = Priority::IDLE;
+};
+}  // namespace Popcorn
+
+#endif  // POPCORN_PRIMITIVES_CEILING_MUTEX_H_
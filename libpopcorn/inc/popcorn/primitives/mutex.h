@@ -18,8 +18,6 @@
 #ifndef POPCORN_PRIMITIVES_MUTEX_H_
 #define POPCORN_PRIMITIVES_MUTEX_H_
 
-#include <atomic>
-
 #include "popcorn/core/lockable.h"
 
 class MutexTest;
@@ -27,12 +25,10 @@ class MutexTest;
 namespace Popcorn {
 class Mutex: Lockable {
  public:
-  Mutex();
   void Lock();
   void Unlock();
 
  private:
-  std::atomic_flag m_held;
   friend MutexTest;
 };
 }  // namespace Popcorn
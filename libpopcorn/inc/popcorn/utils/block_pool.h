@@ -0,0 +1,95 @@
+/*
+ * This file is part of Popcorn
+ * Copyright (c) 2020 Javier Alvarez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POPCORN_UTILS_BLOCK_POOL_H_
+#define POPCORN_UTILS_BLOCK_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+
+class BlockPoolTest;
+
+namespace Popcorn {
+/**
+ * @brief Pool of fixed size blocks carved from a caller provided
+ *        memory region. Allocate and Free take constant time.
+ *
+ * Blocks are handed out from the untouched end of the region until
+ * it is exhausted, and recycled through a free list threaded through
+ * the free blocks themselves. The pool needs no initialization pass,
+ * so it can be constant initialized.
+ */
+class BlockPool {
+ public:
+  constexpr BlockPool() = default;
+
+  /**
+   * @param memory Region holding the blocks. Must be aligned to the
+   *               alignment required for the blocks.
+   * @param block_size Size of each block, at least a pointer.
+   * @param num_blocks Number of blocks in the region.
+   */
+  constexpr BlockPool(std::uint8_t* memory, std::size_t block_size,
+                      std::size_t num_blocks) :
+    m_memory(memory),
+    m_block_size(block_size),
+    m_num_blocks(num_blocks) { }
+
+  /**
+   * @brief Takes a block from the pool.
+   * @return The block, nullptr if the pool is exhausted.
+   */
+  void* Allocate();
+
+  /**
+   * @brief Returns a block to the pool.
+   * @param block Block obtained from Allocate on this pool.
+   */
+  void Free(void* block);
+
+  /**
+   * @brief Whether the pointer lies within the region of the pool.
+   */
+  bool Contains(const void* ptr) const;
+
+  std::size_t BlockSize() const {
+    return m_block_size;
+  }
+
+  std::size_t FreeBlocks() const {
+    return m_num_blocks - m_used_blocks;
+  }
+
+ private:
+  struct free_block {
+    free_block* next;
+  };
+
+  std::uint8_t* m_memory      = nullptr;
+  std::size_t   m_block_size  = 0;
+  std::size_t   m_num_blocks  = 0;
+
+  // Blocks below m_untouched have been handed out at least once
+  std::size_t   m_untouched   = 0;
+  std::size_t   m_used_blocks = 0;
+  free_block*   m_free_list   = nullptr;
+
+  friend ::BlockPoolTest;
+};
+}  // namespace Popcorn
+
+#endif  // POPCORN_UTILS_BLOCK_POOL_H_
@@ -0,0 +1,133 @@
+/*
+ * This file is part of Popcorn
+ * Copyright (c) 2020 Javier Alvarez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POPCORN_UTILS_HEAP_TRACKER_H_
+#define POPCORN_UTILS_HEAP_TRACKER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "popcorn/utils/linked_list.h"
+
+class HeapTrackerTest;
+
+namespace Popcorn {
+/**
+ * @brief Placed in front of every allocation when HEAP_LEAK_TRACKING
+ *        is enabled.
+ */
+struct allocation_tag {
+  ListNode list;
+  const void* owner;
+  // Return address of the caller of the allocation function
+  const void* site;
+  // Requested size
+  std::uint32_t size;
+  // Distance from the start of the underlying block to the allocation
+  std::uint32_t offset;
+};
+
+/**
+ * @brief Instrumentation of the heap behind OsMalloc. Keeps usage
+ *        counters and, optionally, a list of the live allocations with
+ *        their owner task and allocation site.
+ *
+ * The tracker is not thread safe. Callers must serialize accesses.
+ */
+class HeapTracker {
+ public:
+  // Keeps allocations 8 byte aligned after the tag
+  static constexpr std::size_t kTagSize =
+    (sizeof(allocation_tag) + 7U) & ~static_cast<std::size_t>(7U);
+
+  constexpr HeapTracker() = default;
+
+  HeapTracker(const HeapTracker&) = delete;
+  HeapTracker& operator=(const HeapTracker&) = delete;
+
+  /**
+   * @brief Accounts a block taken from the heap.
+   * @param block_size Size of the block, including any rounding.
+   */
+  void RecordAllocation(std::size_t block_size);
+
+  /**
+   * @brief Accounts a block returned to the heap.
+   */
+  void RecordFree(std::size_t block_size);
+
+  /**
+   * @brief Writes a tag in front of an allocation and links it in the
+   *        list of live allocations.
+   * @param block Underlying block returned by the heap.
+   * @param offset Distance from the block to the allocation, at least
+   *               kTagSize.
+   * @return The allocation, to be handed to the application.
+   */
+  void* Tag(void* block, std::size_t offset, std::size_t size,
+            const void* owner, const void* site);
+
+  /**
+   * @brief Unlinks the tag of an allocation.
+   * @return The underlying block, to be returned to the heap.
+   */
+  void* Untag(void* ptr);
+
+  static allocation_tag* TagOf(const void* ptr);
+
+  /**
+   * @brief Total requested size of the live allocations of an owner.
+   */
+  std::size_t UsageOf(const void* owner) const;
+
+  /**
+   * @brief Calls App_HeapLeak_Hook for every live allocation of an
+   *        owner that is going away.
+   * @return The number of leaked allocations.
+   */
+  std::size_t ReportLeaks(const void* owner) const;
+
+  std::size_t BytesInUse() const {
+    return m_bytes_in_use;
+  }
+
+  std::size_t HighWatermark() const {
+    return m_high_watermark;
+  }
+
+  std::size_t Allocations() const {
+    return m_allocations;
+  }
+
+ private:
+  std::size_t m_bytes_in_use = 0;
+  std::size_t m_high_watermark = 0;
+  std::size_t m_allocations = 0;
+  LinkedList<allocation_tag> m_tags;
+
+  friend ::HeapTrackerTest;
+};
+}  // namespace Popcorn
+
+/**
+ * @brief Called for every allocation still owned by a task when it is
+ *        destroyed. The default implementation does nothing.
+ */
+void App_HeapLeak_Hook(const void* owner, const void* ptr, std::size_t size,
+                       const void* site);
+
+#endif  // POPCORN_UTILS_HEAP_TRACKER_H_
@@ -1,64 +1,185 @@
-/* 
+/*
  * This file is part of Popcorn
  * Copyright (c) 2020 Javier Alvarez
- * 
- * This program is free software: you can redistribute it and/or modify  
- * it under the terms of the GNU General Public License as published by  
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
  * the Free Software Foundation, version 3.
  *
- * This program is distributed in the hope that it will be useful, but 
- * WITHOUT ANY WARRANTY; without even the implied warranty of 
- * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
  * General Public License for more details.
  *
- * You should have received a copy of the GNU General Public License 
+ * You should have received a copy of the GNU General Public License
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
-// -V:LinkedList_WalkEntry_Safe:623
-
 #ifndef POPCORN_UTILS_LINKED_LIST_H_
 #define POPCORN_UTILS_LINKED_LIST_H_
 
-#include <stddef.h>
+#include <cstddef>
+#include <cstdint>
+
+namespace Popcorn {
+/**
+ * @brief Links an element in a LinkedList. Elements embed it
+ *        in a member named list.
+ */
+struct ListNode {
+  ListNode* prev = nullptr;
+  ListNode* next = nullptr;
+};
+
+/**
+ * @brief Intrusive doubly linked list. The list is delimited by head
+ *        and tail sentinels, so elements are added and removed in
+ *        constant time without special cases.
+ *
+ * The list does not own its elements. An element can only be linked
+ * in one list at a time through its list member.
+ * @tparam T Type of the elements. It must be standard layout and
+ *           contain a ListNode member named list.
+ */
+template<typename T>
+class LinkedList {
+ public:
+  /**
+   * @brief Forward iterator yielding pointers to the elements. The
+   *        current element must not be removed while walking the list.
+   */
+  class Iterator {
+   public:
+    explicit Iterator(const ListNode* node) : m_node(node) { }
+
+    T* operator*() const {
+      return FromNode(m_node);
+    }
+
+    Iterator& operator++() {
+      m_node = m_node->next;
+      return *this;
+    }
+
+    bool operator!=(const Iterator& other) const {
+      return m_node != other.m_node;
+    }
+
+   private:
+    const ListNode* m_node;
+  };
+
+  constexpr LinkedList() :
+    m_head { nullptr, &m_tail },
+    m_tail { &m_head, nullptr } { }
+
+  // The sentinels are linked to each other, the list can not be copied
+  LinkedList(const LinkedList&) = delete;
+  LinkedList& operator=(const LinkedList&) = delete;
+
+  /**
+   * @brief Empties the list. The elements are left untouched.
+   */
+  void Clear() {
+    m_head.prev = nullptr;
+    m_head.next = &m_tail;
+    m_tail.prev = &m_head;
+    m_tail.next = nullptr;
+  }
+
+  bool Empty() const {
+    return m_head.next == &m_tail;
+  }
+
+  /**
+   * @return The first element, nullptr if the list is empty.
+   */
+  T* Front() const {
+    return Empty() ? nullptr : FromNode(m_head.next);
+  }
+
+  /**
+   * @return The last element, nullptr if the list is empty.
+   */
+  T* Back() const {
+    return Empty() ? nullptr : FromNode(m_tail.prev);
+  }
+
+  /**
+   * @return The element after the given one, nullptr if it is the last.
+   */
+  T* Next(const T* element) const {
+    const ListNode* next = element->list.next;
+    return (next == &m_tail) ? nullptr : FromNode(next);
+  }
 
-#ifdef __cplusplus
-extern "C" {
-#endif
+  void PushBack(T* element) {
+    Link(&element->list, &m_tail);
+  }
 
-typedef struct LinkedList_t_ {
-  struct LinkedList_t_* next;
-} LinkedList_t;
+  void PushFront(T* element) {
+    Link(&element->list, m_head.next);
+  }
 
-#define CONTAINER_OF(ptr, obj, member) \
-  ((obj*)(((ptr) == NULL) ? NULL : (((uint8_t*)(ptr)) - offsetof(obj, member))))  // NOLINT
+  /**
+   * @brief Inserts the element in an ordered list, right before the first
+   *        element that compares greater. Equivalent elements keep their
+   *        insertion order. Takes linear time.
+   * @param before Returns true if its first argument must be placed
+   *               before the second one.
+   */
+  template<typename Compare>
+  void Insert(T* element, Compare before) {
+    ListNode* node = m_head.next;
+    while ((node != &m_tail) && !before(*element, *FromNode(node))) {
+      node = node->next;
+    }
+    Link(&element->list, node);
+  }
 
-#define LinkedList_NextEntry(element, obj, member) \
-  (((element) == NULL) ? NULL : CONTAINER_OF(element->member.next, obj, member))
+  /**
+   * @brief Unlinks the element in constant time. The element must be
+   *        linked in this list, or in none, in which case it is ignored.
+   */
+  void Remove(T* element) {
+    ListNode* node = &element->list;
+    if (node->prev == nullptr) {
+      return;
+    }
 
-#define LinkedList_WalkEntry(head, element, member) \
-  for (element = CONTAINER_OF(head, typeof(*element), member); \
-       element != NULL; \
-       element = CONTAINER_OF(element->member.next, typeof(*element), member))
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = nullptr;
+    node->next = nullptr;
+  }
 
-#define LinkedList_WalkEntry_Safe(head, element, next, member) \
-  for (element = CONTAINER_OF(head, typeof(*element), member), \
-       next = LinkedList_NextEntry(element, typeof(*element), member); \
-       element != NULL; \
-       element = next, \
-       next = LinkedList_NextEntry(element, typeof(*element), member))
+  Iterator begin() const {
+    return Iterator(m_head.next);
+  }
 
-void LinkedList_RemoveElement(LinkedList_t** head, LinkedList_t* element);
-void LinkedList_AddElement(LinkedList_t** head, LinkedList_t* element);
+  Iterator end() const {
+    return Iterator(&m_tail);
+  }
 
-#define LinkedList_AddEntry(head, element, member) \
-  LinkedList_AddElement(&(head), &(element)->member)
+  /**
+   * @brief Recovers the element embedding the given node.
+   */
+  static T* FromNode(const ListNode* node) {
+    auto address = reinterpret_cast<std::uintptr_t>(node);
+    return reinterpret_cast<T*>(address - offsetof(T, list));
+  }
 
-#define LinkedList_RemoveEntry(head, element, member) \
-  LinkedList_RemoveElement(&(head), &(element)->member)
+ private:
+  static void Link(ListNode* node, ListNode* position) {
+    node->prev = position->prev;
+    node->next = position;
+    position->prev->next = node;
+    position->prev = node;
+  }
 
-#ifdef __cplusplus
-}
-#endif
+  ListNode m_head;
+  ListNode m_tail;
+};
+}  // namespace Popcorn
 
 #endif  // POPCORN_UTILS_LINKED_LIST_H_
@@ -25,11 +25,30 @@ extern "C" {
 #include <stddef.h>
 #include <stdint.h>
 
-#define MEMORY_POOL_SIZE        (4096)
-
 void* OsMalloc(size_t size);
+void* OsAlignedAlloc(size_t alignment, size_t size);
+void* OsRealloc(void* ptr, size_t size);
 void OsFree(void* ptr);
 
+struct heap_statistics {
+  // Sizes of the blocks in use, including rounding. Requires
+  // HEAP_STATISTICS
+  size_t bytes_in_use;
+  size_t high_watermark;
+  size_t allocations;
+  // Free memory and largest block that can currently be allocated
+  size_t free_bytes;
+  size_t largest_free_block;
+};
+
+void OsGetHeapStatistics(struct heap_statistics* stats);
+
+// Requires HEAP_LEAK_TRACKING. Owners are task control blocks, or
+// nullptr for allocations made before the scheduler started.
+size_t OsGetHeapUsage(const void* owner);
+void OsSetHeapOwner(void* ptr, const void* owner);
+size_t OsReportHeapLeaks(const void* owner);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,54 @@
+/*
+ * This file is part of Popcorn
+ * Copyright (c) 2020 Javier Alvarez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POPCORN_UTILS_STACK_WATERMARK_H_
+#define POPCORN_UTILS_STACK_WATERMARK_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace Popcorn {
+// Written over unused stack memory
+constexpr std::uint8_t STACK_FILL_PATTERN = 0xA5;
+
+/**
+ * @brief Fills a stack with STACK_FILL_PATTERN.
+ * @param stack Lowest address of the stack.
+ */
+inline void FillStack(std::uint8_t* stack, std::size_t size) {
+  std::memset(stack, STACK_FILL_PATTERN, size);
+}
+
+/**
+ * @brief Measures the deepest point reached by a stack filled with
+ *        FillStack. Stacks grow downwards, so the bytes never written
+ *        are found at the bottom.
+ * @param stack Lowest address of the stack.
+ * @return The number of bytes used at some point.
+ */
+inline std::size_t StackHighWatermark(const std::uint8_t* stack,
+                                      std::size_t size) {
+  std::size_t unused = 0;
+  while ((unused < size) && (stack[unused] == STACK_FILL_PATTERN)) {
+    unused++;
+  }
+  return size - unused;
+}
+}  // namespace Popcorn
+
+#endif  // POPCORN_UTILS_STACK_WATERMARK_H_
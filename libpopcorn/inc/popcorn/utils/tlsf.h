@@ -0,0 +1,172 @@
+/*
+ * This file is part of Popcorn
+ * Copyright (c) 2020 Javier Alvarez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POPCORN_UTILS_TLSF_H_
+#define POPCORN_UTILS_TLSF_H_
+
+#include <cstddef>
+#include <cstdint>
+
+class TlsfTest;
+
+namespace Popcorn {
+/**
+ * @brief Two-Level Segregated Fit allocator over a caller provided
+ *        memory region.
+ *
+ * Free blocks are kept in segregated lists indexed by a first level
+ * (power of two) and a second level (linear subdivision of each power
+ * of two). Two bitmaps locate a suitable list with a couple of bit scan
+ * instructions, so Allocate, AllocateAligned and Free run in constant
+ * time regardless of the state of the heap. Adjacent free blocks are
+ * merged immediately on Free.
+ *
+ * The allocator is not thread safe. Callers must serialize accesses.
+ */
+class Tlsf {
+ public:
+  static constexpr std::size_t kAlignment = 8;
+
+  /**
+   * @param memory Region managed by the allocator, aligned to kAlignment.
+   * @param size Size of the region. The allocator takes ownership of it
+   *             on the first allocation.
+   */
+  constexpr Tlsf(std::uint8_t* memory, std::size_t size) :
+    m_memory(memory),
+    m_size(size) { }
+
+  Tlsf(const Tlsf&) = delete;
+  Tlsf& operator=(const Tlsf&) = delete;
+
+  /**
+   * @brief Allocates a block aligned to kAlignment.
+   * @return The block, nullptr if size is 0 or there is no free block
+   *         large enough.
+   */
+  void* Allocate(std::size_t size);
+
+  /**
+   * @brief Allocates a block aligned to the given power of two.
+   */
+  void* AllocateAligned(std::size_t alignment, std::size_t size);
+
+  /**
+   * @brief Resizes a block, growing it in place when the following
+   *        block is free. Otherwise the contents are moved to a new
+   *        block. On failure the original block is left untouched.
+   * @return The resized block, nullptr on failure or if size is 0.
+   */
+  void* Reallocate(void* ptr, std::size_t size);
+
+  /**
+   * @brief Returns a block to the heap. nullptr is ignored.
+   */
+  void Free(void* ptr);
+
+  /**
+   * @brief Whether the pointer lies within the region of the heap.
+   */
+  bool Contains(const void* ptr) const;
+
+  /**
+   * @brief Usable size of an allocated block, at least the requested size.
+   */
+  std::size_t BlockSize(const void* ptr) const;
+
+  /**
+   * @brief Total payload of the free blocks, in bytes.
+   */
+  std::size_t FreeBytes() const {
+    return m_free_bytes;
+  }
+
+  /**
+   * @brief Payload of the largest free block. Walks the whole heap, so
+   *        it is meant for diagnostics only.
+   */
+  std::size_t LargestFreeBlock() const;
+
+ private:
+  struct block_header {
+    block_header* prev_phys;
+    // Size of the payload. The lowest bit flags free blocks.
+    std::size_t size;
+  };
+
+  // Links of free blocks, stored in their payload
+  struct free_links {
+    block_header* next;
+    block_header* prev;
+  };
+
+  static constexpr std::size_t kHeaderSize =
+    (sizeof(block_header) + kAlignment - 1) & ~(kAlignment - 1);
+  static constexpr std::size_t kMinBlockSize =
+    (sizeof(free_links) + kAlignment - 1) & ~(kAlignment - 1);
+
+  // Second level lists per power of two
+  static constexpr std::uint32_t kSlIndexShift = 4;
+  static constexpr std::uint32_t kSlCount = 1U << kSlIndexShift;
+  // Blocks below kSmallBlockSize are all kept in the first list, split
+  // linearly in kAlignment steps
+  static constexpr std::uint32_t kFlIndexShift = kSlIndexShift + 3;
+  static constexpr std::size_t kSmallBlockSize = 1U << kFlIndexShift;
+  static constexpr std::uint32_t kFlIndexMax = 24;
+  static constexpr std::uint32_t kFlCount = kFlIndexMax - kFlIndexShift + 1;
+  static constexpr std::size_t kMaxBlockSize = 1U << kFlIndexMax;
+
+  static_assert(kSmallBlockSize / kSlCount == kAlignment,
+                "Small blocks must be split in kAlignment steps");
+  static_assert(kFlCount <= 32, "The first level bitmap is too small");
+
+  static std::size_t AlignUp(std::size_t value, std::size_t alignment);
+  static std::size_t Size(const block_header* block);
+  static bool IsFree(const block_header* block);
+  static void* Payload(block_header* block);
+  static block_header* FromPayload(const void* ptr);
+  static block_header* NextPhys(const block_header* block);
+  static free_links* Links(block_header* block);
+  static std::size_t AdjustSize(std::size_t size);
+  static void Mapping(std::size_t size, std::uint32_t* fl,
+                      std::uint32_t* sl);
+  static void MappingSearch(std::size_t size, std::uint32_t* fl,
+                            std::uint32_t* sl);
+
+  void EnsureInitialized();
+  block_header* FindSuitableBlock(std::size_t size);
+  void InsertFreeBlock(block_header* block);
+  void RemoveFreeBlock(block_header* block);
+  void SetSize(block_header* block, std::size_t size, bool free);
+  block_header* Split(block_header* block, std::size_t size);
+  block_header* MergeWithNext(block_header* block);
+  void TrimUsed(block_header* block, std::size_t size);
+
+  std::uint8_t* m_memory;
+  std::size_t m_size;
+  bool m_initialized = false;
+  std::size_t m_free_bytes = 0;
+
+  std::uint32_t m_fl_bitmap = 0;
+  std::uint32_t m_sl_bitmap[kFlCount] = {};
+  block_header* m_free_lists[kFlCount][kSlCount] = {};
+
+  friend ::TlsfTest;
+};
+}  // namespace Popcorn
+
+#endif  // POPCORN_UTILS_TLSF_H_
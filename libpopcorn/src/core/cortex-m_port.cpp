@@ -18,6 +18,9 @@
 // This is an open source non-commercial project. Dear PVS-Studio, please check it.
 // PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
 
+#include <array>
+#include <utility>
+
 #include "popcorn/core/cortex-m_port.h"
 #include "popcorn/core/cortex-m_registers.h"
 #include "popcorn/core/kernel.h"
@@ -41,6 +44,15 @@ using Popcorn::Lockable;
 static_assert(MINIMUM_TASK_STACK_SIZE >
               (sizeof(Hw::task_stack_frame) + sizeof(uint32_t)));
 
+static_assert((STACK_GUARD_SIZE == 0) ||
+              ((STACK_GUARD_SIZE >= 32) &&
+               ((STACK_GUARD_SIZE & (STACK_GUARD_SIZE - 1)) == 0)),
+              "The MPU needs power of two regions of at least 32 bytes");
+
+// Check the stack guard leaves room for the initial stack frame
+static_assert(MINIMUM_TASK_STACK_SIZE >
+              (2 * STACK_GUARD_SIZE + sizeof(Hw::task_stack_frame)));
+
 namespace Hw {
 
 /**
@@ -59,18 +71,40 @@ volatile SCB_t *g_SCB = reinterpret_cast<SCB_t*>(SCB_ADDR);
  */
 volatile SysTick_t *g_SysTick = reinterpret_cast<SysTick_t*>(SYSTICK_ADDR);
 
+/**
+ * @brief MPU (Memory Protection Unit) registers pointer.
+ */
+volatile MPU_t *g_MPU = reinterpret_cast<MPU_t*>(MPU_ADDR);
+
 MCU::MCU() :
   m_syscall_impl(nullptr),
-  m_nested_interrupt_level(0) {
+  m_nested_interrupt_level(0),
+  m_suppressed_ticks(0) {
   g_mcu = this;
   extern volatile uint32_t dummy_asm_symbol;
   (void) dummy_asm_symbol;
 }
 
-void MCU::RegisterSyscallImpl(Popcorn::ISyscall* syscall_impl) {
+void MCU::RegisterSyscallImpl(Popcorn::SyscallImpl* syscall_impl) {
   m_syscall_impl = syscall_impl;
 }
 
+constexpr uint32_t kCyclesPerTick = SYSTICK_SRC_CLK_FREQ_HZ / TICK_FREQ_HZ;
+
+// The highest numbered region wins where regions overlap
+constexpr uint32_t kStackGuardRegion = 7;
+
+constexpr uint32_t StackGuardAttributes() {
+  uint32_t size_log2 = 5;
+  while ((1UL << size_log2) < STACK_GUARD_SIZE) {
+    size_log2++;
+  }
+  return MPU_Rasr_XN
+       | MPU_Rasr_AP_NoAccess
+       | ((size_log2 - 1) << MPU_Rasr_Size_Pos)
+       | MPU_Rasr_Enable;
+}
+
 void MCU::Initialize() const {
   // Set OS IRQ priorities
   g_SCB->SHP[SYSTICK_SHP_IDX] = 0xFF;  // Minimum priority for SysTick
@@ -78,7 +112,7 @@ void MCU::Initialize() const {
   g_SCB->SHP[SVC_CALL_SHP_IDX] = 0x00;  // Maximum priority for SVC
 
   // Configure SysTick
-  g_SysTick->LOAD = SYSTICK_SRC_CLK_FREQ_HZ / TICK_FREQ_HZ - 1;
+  g_SysTick->LOAD = kCyclesPerTick - 1;
   g_SysTick->VAL = 0U;
   g_SysTick->CTRL = SysTick_Ctrl_Enable
                   | SysTick_Ctrl_TickInt
@@ -88,104 +122,217 @@ void MCU::Initialize() const {
   // On entry, the stacked value of the XPSR register will have
   // bit 9 set to 1 if the stack was aligned to 8 bytes.
   g_SCB->CCR = SCB_CCR_STKALIGN | g_SCB->CCR;
+
+  if constexpr (STACK_GUARD_SIZE > 0) {
+    // The guard is the only region. The default memory map applies
+    // everywhere else. It is placed by the first context switch.
+    g_MPU->RNR = kStackGuardRegion;
+    g_MPU->RASR = 0U;
+    g_MPU->CTRL = MPU_Ctrl_PrivDefEna | MPU_Ctrl_Enable;
+  }
+}
+
+void MCU::SetStackGuard(uintptr_t base) const {
+  // Selecting the region through RBAR saves a write to RNR
+  g_MPU->RBAR = static_cast<uint32_t>(base) | MPU_Rbar_Valid
+              | kStackGuardRegion;
+  g_MPU->RASR = StackGuardAttributes();
 }
 
 void MCU::TriggerPendSV() const {
   g_SCB->ICSR = SCB_ICSR_PENDSVSET | g_SCB->ICSR;
 }
 
-void MCU::HandleSVC_Static(struct auto_task_stack_frame* args) {
+uint32_t MCU::SuppressTicks(uint32_t ticks) {
+  constexpr uint32_t kMaxTicks = (SysTick_Load_Max + 1) / kCyclesPerTick;
+  if (ticks > kMaxTicks) {
+    ticks = kMaxTicks;
+  }
+
+  // A pending tick would be accounted for twice, and suppressing a
+  // single tick saves nothing.
+  if ((ticks < 2) || (g_SCB->ICSR & SCB_ICSR_PENDSTSET)) {
+    return 0;
+  }
+
+  // Stop the timer and extend the current tick period. The cycles left
+  // in the current tick are kept so that the tick phase is preserved.
+  g_SysTick->CTRL = SysTick_Ctrl_TickInt | SysTick_Ctrl_ClkSource;
+  uint32_t remaining_cycles = g_SysTick->VAL;
+  g_SysTick->LOAD = remaining_cycles + (ticks - 1) * kCyclesPerTick - 1;
+  g_SysTick->VAL = 0U;
+  g_SysTick->CTRL = SysTick_Ctrl_Enable
+                  | SysTick_Ctrl_TickInt
+                  | SysTick_Ctrl_ClkSource;
+
+  m_suppressed_ticks = ticks;
+  return ticks;
+}
+
+uint32_t MCU::RestoreTicks() {
+  if (m_suppressed_ticks == 0) {
+    return 0;
+  }
+
+  // Reading CTRL clears the count flag, which tells whether the whole
+  // suppressed period expired.
+  uint32_t ctrl = g_SysTick->CTRL;
+  uint32_t elapsed_ticks = m_suppressed_ticks;
+  if ((ctrl & SysTick_Ctrl_CountFlag) == 0) {
+    // Woken up early. Tick boundaries are located at multiples of the
+    // tick period from the end of the suppressed period.
+    elapsed_ticks = m_suppressed_ticks - 1 - g_SysTick->VAL / kCyclesPerTick;
+  }
+
+  g_SysTick->LOAD = kCyclesPerTick - 1;
+  g_SysTick->VAL = 0U;
+  g_SysTick->CTRL = SysTick_Ctrl_Enable
+                  | SysTick_Ctrl_TickInt
+                  | SysTick_Ctrl_ClkSource;
+
+  m_suppressed_ticks = 0;
+  return elapsed_ticks;
+}
+
+bool MCU::HandleSVC_Static(struct auto_task_stack_frame* args,
+                           bool from_task) {
   g_mcu->HandleSVC(args);
+
+  // A blocking call from a task switches on the way out of the SVC
+  // handler, saving the PendSV exception. Calls made on the main stack
+  // still leave the switch to PendSV, which starts the first task.
+  return from_task && g_mcu->TakePendingContextSwitch();
 }
 
-SyscallIdx MCU::GetSVCCode(const uint8_t* pc) const {
-  // First byte of svc instruction
-  return static_cast<SyscallIdx>(pc[-sizeof(uint16_t)]);
+bool MCU::TakePendingContextSwitch() const {
+  if ((g_SCB->ICSR & SCB_ICSR_PENDSVSET) == 0) {
+    return false;
+  }
+  g_SCB->ICSR = SCB_ICSR_PENDSVCLR;
+  return true;
 }
 
+namespace {
+using SyscallHandler = void (*)(Popcorn::SyscallImpl* impl,
+                                const auto_task_stack_frame* args);
+
+/**
+ * @brief Unpacks the arguments of a system call from the registers
+ *        stacked on exception entry. One specialization per call.
+ */
+template<SyscallIdx id>
+void Dispatch(Popcorn::SyscallImpl* impl, const auto_task_stack_frame* args);
+
+template<>
+void Dispatch<SyscallIdx::StartOS>(Popcorn::SyscallImpl* impl,
+                                   const auto_task_stack_frame* args) {
+  impl->StartOS();
+}
+
+template<>
+void Dispatch<SyscallIdx::CreateTask>(Popcorn::SyscallImpl* impl,
+                                      const auto_task_stack_frame* args) {
+  const auto* task = reinterpret_cast<const create_task_args*>(args->r0);
+  ATE_ASSERT(task != nullptr);
+  impl->CreateTask(task->func, task->arg, task->priority, task->name,
+                   task->stack_size);
+}
+
+template<>
+void Dispatch<SyscallIdx::Sleep>(Popcorn::SyscallImpl* impl,
+                                 const auto_task_stack_frame* args) {
+  impl->Sleep(args->r0);
+}
+
+template<>
+void Dispatch<SyscallIdx::DestroyTask>(Popcorn::SyscallImpl* impl,
+                                       const auto_task_stack_frame* args) {
+  impl->DestroyTask();
+}
+
+template<>
+void Dispatch<SyscallIdx::Yield>(Popcorn::SyscallImpl* impl,
+                                 const auto_task_stack_frame* args) {
+  impl->Yield();
+}
+
+template<>
+void Dispatch<SyscallIdx::Wait>(Popcorn::SyscallImpl* impl,
+                                const auto_task_stack_frame* args) {
+  auto* mutex = reinterpret_cast<Lockable*>(args->r0);
+  ATE_ASSERT(mutex != nullptr);
+  impl->Wait(*mutex);
+}
+
+template<>
+void Dispatch<SyscallIdx::RegisterError>(Popcorn::SyscallImpl* impl,
+                                         const auto_task_stack_frame* args) {
+  /**
+   * @todo (javier_varez) Handle Register Error SVC call and register
+   *       backtrace
+   */
+  impl->RegisterError();
+}
+
+template<>
+void Dispatch<SyscallIdx::Lock>(Popcorn::SyscallImpl* impl,
+                                const auto_task_stack_frame* args) {
+  auto* mutex = reinterpret_cast<Lockable*>(args->r0);
+  auto acquired = static_cast<bool>(args->r1);
+  ATE_ASSERT(mutex != nullptr);
+  impl->Lock(*mutex, acquired);
+}
+
+template<>
+void Dispatch<SyscallIdx::CreatePeriodicTask>(
+    Popcorn::SyscallImpl* impl, const auto_task_stack_frame* args) {
+  auto func = reinterpret_cast<Popcorn::task_func>(args->r0);
+  auto arg = reinterpret_cast<void*>(args->r1);
+  const auto* params =
+    reinterpret_cast<const Popcorn::periodic_task_params*>(args->r2);
+  ATE_ASSERT(params != nullptr);
+  impl->CreatePeriodicTask(func, arg, *params);
+}
+
+template<>
+void Dispatch<SyscallIdx::WaitForNextPeriod>(
+    Popcorn::SyscallImpl* impl, const auto_task_stack_frame* args) {
+  impl->WaitForNextPeriod();
+}
+
+template<>
+void Dispatch<SyscallIdx::CreateTaskStatic>(
+    Popcorn::SyscallImpl* impl, const auto_task_stack_frame* args) {
+  auto func = reinterpret_cast<Popcorn::task_func>(args->r0);
+  auto arg = reinterpret_cast<void*>(args->r1);
+  const auto* params =
+    reinterpret_cast<const Popcorn::static_task_params*>(args->r2);
+  ATE_ASSERT(params != nullptr);
+  impl->CreateTaskStatic(func, arg, *params);
+}
+
+template<std::size_t... kIds>
+constexpr std::array<SyscallHandler, sizeof...(kIds)>
+MakeSyscallTable(std::index_sequence<kIds...>) {
+  return { &Dispatch<static_cast<SyscallIdx>(kIds)>... };
+}
+
+// Indexed by SyscallIdx, placed in flash
+constexpr auto kSyscallTable =
+  MakeSyscallTable(std::make_index_sequence<Popcorn::NUM_SYSCALLS>());
+}  // namespace
+
 void MCU::HandleSVC(struct auto_task_stack_frame* args) const {
-  const uint8_t* pc = reinterpret_cast<uint8_t*>(args->pc);
-  SyscallIdx svc_code = GetSVCCode(pc);
-  // The arguments for the original function calls will be in
-  // r0 to r3. If more arguments are required, they are placed in
-  // the stack in order. Look into the ARM EABI for details.
-  // Another good document is the AAPCS, which documents the
-  // ARM Architecture Procedure Calling Standard.
-
-  // On exception entry, the stack must be 8 byte aligned
-  // (if STKALIGN is 1) and it is possible that the processor
-  // introduced padding in addition to just performing the stacking
-  // of registers. This is why we need to check bit 9 of the stacked
-  // XPSR register. This bit will be set to 1 if it was 4 byte aligned
-  // on exception entry.
-  uint32_t* original_call_stack = reinterpret_cast<uint32_t*>(args+1);
-  bool fourByteAlignedOnEntry = args->xpsr & (1 << 9);
-  if (fourByteAlignedOnEntry) {
-    original_call_stack += 1;
-  }
   ATE_ASSERT(m_syscall_impl != nullptr);
 
-  switch (svc_code) {
-    case SyscallIdx::StartOS: {
-        m_syscall_impl->StartOS();
-        break;
-      }
-
-    case SyscallIdx::CreateTask: {
-        auto func = reinterpret_cast<Popcorn::task_func>(args->r1);
-        auto arg = reinterpret_cast<void*>(args->r2);
-        auto priority = static_cast<Priority>(args->r3);
-        const auto* name = reinterpret_cast<char*>(*original_call_stack);
-        auto stack_size = static_cast<uint32_t>(*(original_call_stack + 1));
-        m_syscall_impl->CreateTask(func,
-                             arg,
-                             priority,
-                             name,
-                             stack_size);
-        break;
-      }
-
-    case SyscallIdx::Sleep: {
-        auto ticks = args->r1;
-        m_syscall_impl->Sleep(ticks);
-        break;
-      }
-
-    case SyscallIdx::DestroyTask: {
-        m_syscall_impl->DestroyTask();
-        break;
-      }
-
-    case SyscallIdx::Yield: {
-        m_syscall_impl->Yield();
-        break;
-      }
-
-    case SyscallIdx::Wait: {
-        const auto* mutex = reinterpret_cast<Lockable*>(args->r1);
-        ATE_ASSERT(mutex != nullptr);
-        m_syscall_impl->Wait(*mutex);
-        break;
-      }
-
-    case SyscallIdx::Lock: {
-        auto* mutex = reinterpret_cast<Lockable*>(args->r1);
-        auto acquired = static_cast<bool>(args->r2);
-        ATE_ASSERT(mutex != nullptr);
-        m_syscall_impl->Lock(*mutex, acquired);
-        break;
-      }
-
-    case SyscallIdx::RegisterError:
-    default: {
-        /**
-         * @todo (javier_varez) Handle Register Error SVC call and register
-         *       backtrace
-         */
-        m_syscall_impl->RegisterError();
-        break;
-      }
+  // The caller placed the number of the system call in r12 and the
+  // arguments in r0 to r2, so they are all found in the registers
+  // stacked on exception entry. Unknown calls are reported as errors.
+  uint32_t idx = args->r12;
+  if (idx >= kSyscallTable.size()) {
+    idx = static_cast<uint32_t>(SyscallIdx::RegisterError);
   }
+  kSyscallTable[idx](m_syscall_impl, args);
 }
 
 void MCU::DisableInterrupts() {
@@ -262,6 +409,23 @@ __WEAK void MCU::DisableInterruptsInternal() const { }
  */
 __WEAK void MCU::EnableInterruptsInternal() const { }
 
+/**
+ * @brief Weak definition for testing purposes only.
+ *        The actual implementation requires assembly
+ *        and is located in cortex-m_port_asm.cpp
+ */
+__WEAK void MCU::WaitForInterrupt() { }
+
+/**
+ * @brief Weak definition for testing purposes only.
+ *        The actual implementation requires assembly
+ *        and is located in cortex-m_port_asm.cpp
+ * @return hardcoded to nullptr in this fake implementation.
+ */
+__WEAK std::uint8_t* MCU::FillMainStack(std::uint32_t size) {
+  return nullptr;
+}
+
 /**
  * @brief Weak definition for testing purposes only.
  *        The actual implementation requires assembly
@@ -20,6 +20,7 @@
 
 #include "popcorn/core/cortex-m_port.h"
 #include "popcorn/core/kernel.h"
+#include "popcorn/utils/stack_watermark.h"
 
 namespace Popcorn {
   extern Kernel *g_kernel;
@@ -33,16 +34,23 @@ namespace Hw {
 }  // namespace HW
 
 CLINKAGE __NAKED void PendSV_Handler() {
+  // r4-r11 are preserved by TriggerScheduler, so the context of the
+  // previous task is only saved once the scheduler picked another one
   asm volatile (
-    "               ldr r1, [%[current_task_ptr]]     \n"
+    "               ldr r1, [%[current_task_ptr]]     \n" // r1 = previous task
+    "               push {r0, r1}                     \n" // r0 keeps 8 byte alignment
+    "               push {%[current_task_ptr], lr}    \n"
+    "               blx %[TriggerScheduler]           \n"
+    "               pop {%[current_task_ptr], lr}     \n"
+    "               pop {r0, r1}                      \n"
+    "               ldr r0, [%[current_task_ptr]]     \n"
+    "               cmp r0, r1                        \n"
+    "               beq RetISR                        \n" // Same task, keep context
     "               cbz r1, TaskSwitch                \n"
     "               mrs r0, psp                       \n"
     "               stmdb r0!, {r4-r11, r14}          \n"
-    "               str r0, [r1]                      \n" // scheduler.current_task->stack_ptr = psp
-    "TaskSwitch:    push {%[current_task_ptr], lr}    \n"
-    "               blx %[TriggerScheduler]           \n"
-    "               pop {%[current_task_ptr], lr}     \n"
-    "               ldr r1, [%[current_task_ptr]]     \n"
+    "               str r0, [r1]                      \n" // previous->stack_ptr = psp
+    "TaskSwitch:    ldr r1, [%[current_task_ptr]]     \n"
     "               cbz r1, RetISR                    \n"
     "               ldr r0, [r1]                      \n"
     "               ldmia r0!, {r4-r11, r14}          \n"
@@ -64,9 +72,16 @@ CLINKAGE __NAKED void SVC_Handler() {
     "    ite eq                  \n"
     "    mrseq r0, msp           \n"
     "    mrsne r0, psp           \n"
-    "    bx %[svc_handler]       \n"
+    "    and r1, lr, #4          \n" // from_task = lr & EXC_RETURN_SPSEL
+    "    push {r4, lr}           \n" // r4 keeps the stack 8 byte aligned
+    "    blx %[svc_handler]      \n"
+    "    pop {r4, lr}            \n"
+    "    cbz r0, SvcReturn       \n"
+    "    b PendSV_Handler        \n" // Switch now, the task frame is intact
+    "SvcReturn:                  \n"
+    "    bx lr                   \n"
     : : [svc_handler] "r" (Hw::MCU::HandleSVC_Static)
-    : "r0", "lr"
+    : "r0", "r1", "lr"
   );
 }
 
@@ -79,6 +94,28 @@ void MCU::EnableInterruptsInternal() const {
   asm volatile("cpsie i");
 }
 
+void MCU::WaitForInterrupt() {
+  asm volatile("wfi");
+}
+
+std::uint8_t* MCU::FillMainStack(std::uint32_t size) {
+  std::uint8_t* stack_ptr;
+  asm volatile("mrs %[sp], msp" : [sp] "=r" (stack_ptr));
+
+  // Only memory below the stack pointer is written, so the frame of
+  // this function is preserved. Word writes through a volatile pointer
+  // keep the compiler from replacing the loop with a call to memset.
+  constexpr std::uint32_t kPattern = 0x01010101U * Popcorn::STACK_FILL_PATTERN;
+  auto* bottom = reinterpret_cast<volatile std::uint32_t*>(
+    reinterpret_cast<std::uintptr_t>(stack_ptr - size) & ~3U);
+  auto* top = reinterpret_cast<volatile std::uint32_t*>(stack_ptr);
+  for (auto* word = bottom; word < top; word++) {
+    *word = kPattern;
+  }
+  return const_cast<std::uint8_t*>(
+    reinterpret_cast<volatile std::uint8_t*>(bottom));
+}
+
 std::uintptr_t GetPC() {
   std::uintptr_t lr = 0;
   asm volatile (
@@ -18,15 +18,19 @@
 // This is an open source non-commercial project. Dear PVS-Studio, please check it.
 // PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
 
+#include <algorithm>
 #include <cstddef>
 #include <cstring>
+#include <new>
 
 #include "popcorn/core/kernel.h"
+#include "popcorn/API/static_task.h"
 #include "popcorn/core/cortex-m_port.h"
 #include "popcorn/core/syscall_idx.h"
 #include "popcorn/core/lockable.h"
 
 #include "popcorn/utils/memory_management.h"
+#include "popcorn/utils/stack_watermark.h"
 
 #include "popcorn/primitives/critical_section.h"
 
@@ -38,66 +42,207 @@ using std::uintptr_t;
 namespace Popcorn {
 Kernel* g_kernel = nullptr;
 
-uint8_t* Kernel::AllocateTaskStack(Popcorn::task_control_block *tcb,
-                                   size_t size) const {
-  uint8_t* task_stack_top = nullptr;
-
-  uint8_t* stack = reinterpret_cast<uint8_t*>(OsMalloc(size));
-  if (stack != nullptr) {
-    tcb->stack_base = reinterpret_cast<uintptr_t>(&stack[0]);
-    task_stack_top = reinterpret_cast<uint8_t*>(&stack[size]);
-  }
+namespace {
+bool WakesUpEarlier(const task_control_block& a,
+                    const task_control_block& b) {
+  return a.blockArgument.timestamp < b.blockArgument.timestamp;
+}
 
-  return task_stack_top;
+bool HasHigherPriority(const task_control_block& a,
+                       const task_control_block& b) {
+  return a.priority > b.priority;
 }
+}  // namespace
 
-void Kernel::CreateTask(task_func func,
-                            void* arg,
-                            Priority priority,
-                            const char* name,
-                            uint32_t stack_size) {
-  task_control_block* tcb = reinterpret_cast<task_control_block*>(
-    OsMalloc(sizeof(task_control_block)));
-  if (nullptr == tcb) {
+void Kernel::SetTaskPriority(task_control_block* tcb, Priority priority) {
+  if (tcb->priority == priority) {
     return;
   }
 
-  stack_size = stack_size < MINIMUM_TASK_STACK_SIZE ?
-               MINIMUM_TASK_STACK_SIZE : stack_size;
-
-  uint8_t* task_stack_top = AllocateTaskStack(tcb, stack_size);
-  if (task_stack_top == nullptr) {
-    OsFree(tcb);
-    return;
+  bool runnable = (tcb->state == task_state::READY) ||
+                  (tcb->state == task_state::RUNNING);
+  if (runnable) {
+    m_scheduler.RemoveReadyTask(tcb);
+  }
+  tcb->priority = priority;
+  if (runnable) {
+    m_scheduler.AddReadyTask(tcb);
   }
+}
 
-  uint8_t* task_stack = m_mcu->InitializeTask(task_stack_top, func, arg);
+task_control_block* Kernel::ConstructTask(void* memory,
+                                          uint8_t* stack,
+                                          size_t stack_size,
+                                          task_func func,
+                                          void* arg,
+                                          Priority priority,
+                                          const char* name) {
+  auto* tcb = new (memory) task_control_block();
+
+  if constexpr (STACK_WATERMARK) {
+    FillStack(stack, stack_size);
+  }
+  uint8_t* task_stack = m_mcu->InitializeTask(&stack[stack_size], func, arg);
 
   auto task_stack_ptr = reinterpret_cast<uintptr_t>(task_stack);
   tcb->stack_ptr = task_stack_ptr;
+  tcb->stack_base = reinterpret_cast<uintptr_t>(stack);
+  tcb->stack_size = stack_size;
+  if constexpr (STACK_GUARD_SIZE > 0) {
+    // Regions are aligned to their size, so the guard takes the first
+    // aligned block of the stack.
+    tcb->stack_guard = (tcb->stack_base + STACK_GUARD_SIZE - 1) &
+                       ~static_cast<uintptr_t>(STACK_GUARD_SIZE - 1);
+  }
   tcb->arg = reinterpret_cast<uintptr_t>(arg);
   tcb->priority = priority;
   tcb->base_priority = priority;
+  tcb->ceiling = Priority::IDLE;
+  // Tasks without a deadline run after all periodic tasks under EDF
+  tcb->deadline = UINT64_MAX;
+  tcb->period = 0;
+  tcb->relative_deadline = 0;
   tcb->func = func;
   tcb->state = task_state::READY;
-  tcb->run_last_timestamp = 0;  // never
   strncpy(tcb->name, name, MAX_TASK_NAME);
-  LinkedList_AddEntry(m_ready_list, tcb, list);
+  return tcb;
+}
+
+task_control_block* Kernel::AllocateTask(task_func func,
+                                         void* arg,
+                                         Priority priority,
+                                         const char* name,
+                                         uint32_t stack_size) {
+  if constexpr (!DYNAMIC_TASK_ALLOCATION) {
+    // Without a heap tasks can only be created by CreateTaskStatic
+    ATE_ASSERT(false);
+    return nullptr;
+  } else {
+    stack_size = stack_size < MINIMUM_TASK_STACK_SIZE ?
+                 MINIMUM_TASK_STACK_SIZE : stack_size;
+
+    // Reuse the storage of a destroyed task with the same stack size
+    if (auto* cached = m_task_cache.Take(stack_size)) {
+      auto* stack = reinterpret_cast<uint8_t*>(cached->stack_base);
+      auto* tcb = ConstructTask(cached, stack, stack_size, func, arg,
+                                priority, name);
+      if constexpr (HEAP_LEAK_TRACKING) {
+        OsSetHeapOwner(tcb, tcb);
+        OsSetHeapOwner(stack, tcb);
+      }
+      return tcb;
+    }
+
+    void* memory = OsMalloc(sizeof(task_control_block));
+    if (nullptr == memory) {
+      return nullptr;
+    }
+
+    auto* stack = reinterpret_cast<uint8_t*>(OsMalloc(stack_size));
+    if (stack == nullptr) {
+      OsFree(memory);
+      return nullptr;
+    }
+
+    auto* tcb = ConstructTask(memory, stack, stack_size, func, arg,
+                              priority, name);
+    if constexpr (HEAP_LEAK_TRACKING) {
+      // The storage of the task is accounted to the task itself
+      OsSetHeapOwner(memory, tcb);
+      OsSetHeapOwner(stack, tcb);
+    }
+    return tcb;
+  }
+}
+
+void Kernel::CreateTask(task_func func,
+                        void* arg,
+                        Priority priority,
+                        const char* name,
+                        uint32_t stack_size) {
+  auto* tcb = AllocateTask(func, arg, priority, name, stack_size);
+  if (tcb) {
+    m_scheduler.AddReadyTask(tcb);
+  }
+}
+
+void Kernel::CreateTaskStatic(task_func func,
+                              void* arg,
+                              const static_task_params& params) {
+  ATE_ASSERT((params.tcb != nullptr) && (params.stack != nullptr));
+  ATE_ASSERT(params.stack_size >= MINIMUM_TASK_STACK_SIZE);
+  auto* tcb = ConstructTask(params.tcb, params.stack, params.stack_size,
+                            func, arg, params.priority, params.name);
+  tcb->static_storage = true;
+  m_scheduler.AddReadyTask(tcb);
+}
+
+void Kernel::CreatePeriodicTask(task_func func,
+                                void* arg,
+                                const periodic_task_params& params) {
+  ATE_ASSERT(params.period > 0);
+  auto* tcb = AllocateTask(func, arg, params.priority,
+                           params.name, params.stack_size);
+  if (!tcb) {
+    return;
+  }
+
+  // The first job is released now
+  tcb->period = params.period;
+  tcb->relative_deadline = params.deadline ? params.deadline : params.period;
+  tcb->deadline = GetTicks() + tcb->relative_deadline;
+  m_scheduler.AddReadyTask(tcb);
+}
+
+void Kernel::WaitForNextPeriod() {
+  task_control_block* tcb = m_current_task;
+  ATE_ASSERT(tcb->period != 0);
+
+  // The deadline is the key of the task in the ready set, it can
+  // only be updated while the task is out of it.
+  m_scheduler.RemoveReadyTask(tcb);
+  uint64_t release = tcb->deadline - tcb->relative_deadline + tcb->period;
+  tcb->deadline = release + tcb->relative_deadline;
+
+  if (release <= GetTicks()) {
+    // The job overran its period, the next one is already released
+    m_scheduler.AddReadyTask(tcb);
+    RequestContextSwitch(true);
+    return;
+  }
+
+  // The task is released again by HandleTick when it wakes up
+  SleepUntil(tcb, release);
 }
 
 void IdleTask(void *arg) {
   (void)arg;
-  while (1) { }
+  while (1) {
+    Hw::MCU::WaitForInterrupt();
+  }
 }
 
 void Kernel::StartOS() {
   // The idle task will run whenever there is no other
   // good candidate to run. It has the lowest priority.
-  CreateTask(IdleTask,
-             nullptr,
-             Priority::IDLE,
-             "Idle",
-             MINIMUM_TASK_STACK_SIZE);
+  if constexpr (DYNAMIC_TASK_ALLOCATION) {
+    CreateTask(IdleTask,
+               nullptr,
+               Priority::IDLE,
+               "Idle",
+               MINIMUM_TASK_STACK_SIZE);
+  } else {
+    static StaticTask<MINIMUM_TASK_STACK_SIZE> idle_task;
+    CreateTaskStatic(IdleTask,
+                     nullptr,
+                     idle_task.Params(Priority::IDLE, "Idle"));
+  }
+
+  if constexpr (ISR_STACK_SIZE > 0) {
+    // From now on the main stack is only used by exception handlers
+    m_isr_stack = m_mcu->FillMainStack(ISR_STACK_SIZE);
+    m_isr_stack_size = ISR_STACK_SIZE;
+  }
 
   // Configure interrupts and priorities.
   m_mcu->Initialize();
@@ -105,6 +250,29 @@ void Kernel::StartOS() {
   m_mcu->TriggerPendSV();
 }
 
+uint32_t Kernel::GetStackHighWatermark(
+    const task_control_block* tcb) const {
+  if constexpr (!STACK_WATERMARK) {
+    return 0;
+  }
+  uintptr_t bottom = tcb->stack_base;
+  if constexpr (STACK_GUARD_SIZE > 0) {
+    // The guard of the running task cannot be read, and it is never
+    // written anyway
+    bottom = tcb->stack_guard + STACK_GUARD_SIZE;
+  }
+  auto* stack = reinterpret_cast<const uint8_t*>(bottom);
+  return StackHighWatermark(stack,
+                            tcb->stack_base + tcb->stack_size - bottom);
+}
+
+uint32_t Kernel::GetIsrStackHighWatermark() const {
+  if (m_isr_stack == nullptr) {
+    return 0;
+  }
+  return StackHighWatermark(m_isr_stack, m_isr_stack_size);
+}
+
 uint64_t Kernel::GetTicks() {
   CriticalSection s;
   return m_ticks;
@@ -112,12 +280,19 @@ uint64_t Kernel::GetTicks() {
 
 void Kernel::Sleep(uint32_t num_ticks) {
   task_control_block* tcb = m_current_task;
-  tcb->blockArgument.timestamp = num_ticks + GetTicks();
+
+  m_scheduler.RemoveReadyTask(tcb);
+  SleepUntil(tcb, num_ticks + GetTicks());
+}
+
+void Kernel::SleepUntil(task_control_block* tcb, uint64_t timestamp) {
+  ATE_ASSERT(tcb->ceiling == Priority::IDLE);
+  tcb->blockArgument.timestamp = timestamp;
 
   // Send task to sleep
   tcb->state = task_state::SLEEPING;
-  LinkedList_RemoveEntry(m_ready_list, tcb, list);
-  LinkedList_AddEntry(m_sleeping_list, tcb, list);
+  // The sleeping list is kept ordered by wake up time
+  m_sleeping_list.Insert(tcb, WakesUpEarlier);
 
   m_mcu->TriggerPendSV();
 }
@@ -128,10 +303,26 @@ void Kernel::DestroyTask() {
   }
 
   task_control_block *tcb = m_current_task;
-  // Remove task from task_list and free space
-  LinkedList_RemoveEntry(m_ready_list, tcb, list);
-  OsFree(reinterpret_cast<void*>(tcb->stack_base));
-  OsFree(tcb);
+  // Remove task from task_list and free or park its storage. The
+  // storage of static tasks belongs to the application.
+  m_scheduler.RemoveReadyTask(tcb);
+  if constexpr (DYNAMIC_TASK_ALLOCATION) {
+    auto* stack = reinterpret_cast<void*>(tcb->stack_base);
+    if (!tcb->static_storage) {
+      if (!m_task_cache.Park(tcb)) {
+        OsFree(stack);
+        OsFree(tcb);
+      } else if constexpr (HEAP_LEAK_TRACKING) {
+        // Parked storage belongs to the kernel, not to the dead task
+        OsSetHeapOwner(tcb, &m_task_cache);
+        OsSetHeapOwner(stack, &m_task_cache);
+      }
+    }
+  }
+  if constexpr (HEAP_LEAK_TRACKING) {
+    // Whatever the task still owns is leaked
+    OsReportHeapLeaks(tcb);
+  }
 
   m_current_task = nullptr;
 
@@ -140,28 +331,52 @@ void Kernel::DestroyTask() {
 }
 
 void Kernel::Yield() {
-  // Scheduler needs to run and check which task to run
-  m_mcu->TriggerPendSV();
+  // Give up the rest of the time slice, letting tasks
+  // of equal priority run before the current one.
+  if (m_current_task) {
+    m_scheduler.RemoveReadyTask(m_current_task);
+    m_scheduler.AddReadyTask(m_current_task);
+  }
+
+  // Scheduler needs to run if there is any other task to run
+  RequestContextSwitch(true);
 }
 
-void Kernel::Wait(const Lockable& lockable) {
+void Kernel::Wait(Lockable& lockable) {
   task_control_block* tcb = m_current_task;
 
+  // Tasks can not touch the owner word while the kernel runs
+  std::uintptr_t state = lockable.m_state.load(std::memory_order_relaxed);
+  if (state == 0) {
+    // The resource was released before the task could block,
+    // it can be taken right away
+    lockable.m_state.store(reinterpret_cast<std::uintptr_t>(tcb),
+                           std::memory_order_relaxed);
+    return;
+  }
+
+  if ((state & Lockable::kKernelOwnedBit) == 0) {
+    // The owner took the resource without the kernel. Track it from
+    // now on, so that it inherits priority and releases the resource
+    // through the kernel.
+    auto *owner = reinterpret_cast<task_control_block*>(state);
+    lockable.m_state.store(state | Lockable::kKernelOwnedBit,
+                           std::memory_order_relaxed);
+    SetLockOwner(lockable, owner);
+  }
+
+  // Take the current task from the ready list and queue it on the
+  // waiters of the resource, highest priority first
+  ATE_ASSERT(tcb->ceiling == Priority::IDLE);
+  m_scheduler.RemoveReadyTask(tcb);
+  lockable.m_waiters.Insert(tcb, HasHigherPriority);
+
   // Send task to the blocked state
   tcb->state = task_state::BLOCKED;
   tcb->blockArgument.lockable = &lockable;
 
-  auto *blocker_task = lockable.GetBlockerTask();
-  ATE_ASSERT(nullptr != blocker_task);
-  if (blocker_task->priority < m_current_task->priority) {
-    /* Inherit priority */
-    blocker_task->priority = m_current_task->priority;
-  }
-
-  // Take the current task from the ready list and move it to the
-  // blocked list
-  LinkedList_RemoveEntry(m_ready_list, tcb, list);
-  LinkedList_AddEntry(m_blocked_list, tcb, list);
+  // Inherit priority along the chain of blockers
+  UpdateInheritedPriority(lockable.GetBlockerTask());
 
   // Scheduler needs to select another task to run as
   // priorities may have changed and the current task is not
@@ -170,36 +385,46 @@ void Kernel::Wait(const Lockable& lockable) {
 }
 
 void Kernel::Lock(Lockable& lockable, bool acquired) {
+  auto self = reinterpret_cast<std::uintptr_t>(m_current_task);
   if (acquired) {
-    lockable.SetBlockerTask(m_current_task);
+    ATE_ASSERT((lockable.m_state.load(std::memory_order_relaxed) &
+                ~Lockable::kKernelOwnedBit) == self);
+    lockable.m_state.store(self | Lockable::kKernelOwnedBit,
+                           std::memory_order_relaxed);
+    SetLockOwner(lockable, m_current_task);
+    UpdateInheritedPriority(m_current_task);
   } else {
-    // Restore original priority of the blocker
     auto *blocker_task = lockable.GetBlockerTask();
     ATE_ASSERT(nullptr != blocker_task);
-    blocker_task->priority = blocker_task->base_priority;
-    lockable.SetBlockerTask(nullptr);
-
-    // Bring back blocked tasks by this resource
-    task_control_block *tcb = nullptr;
-    task_control_block *tcb_next = nullptr;
-
-    LinkedList_WalkEntry_Safe(m_blocked_list, tcb, tcb_next, list) {
-      // Walk through the list and make sure that all the
-      // tasks that were blocked by this resource are now
-      // ready to run.
-      // This means removing them from the blocked list and
-      // adding them back to the ready list.
-      //
-      // Using LinkedList_WalkEntry_Safe because we are removing
-      // elements of the list inside the loop
-      if (tcb->blockArgument.lockable == &lockable) {
-        LinkedList_RemoveEntry(m_blocked_list, tcb, list);
-        LinkedList_AddEntry(m_ready_list, tcb, list);
-        tcb->state = task_state::READY;
+
+    if (!lockable.m_waiters.Empty()) {
+      // Hand the resource over to the highest priority waiter, which
+      // is the only one woken up.
+      task_control_block *tcb = lockable.m_waiters.Front();
+      lockable.m_waiters.Remove(tcb);
+      tcb->state = task_state::READY;
+      m_scheduler.AddReadyTask(tcb);
+
+      auto owner = reinterpret_cast<std::uintptr_t>(tcb);
+      if (lockable.m_waiters.Empty()) {
+        // Nobody else waits, the new owner can release it alone
+        SetLockOwner(lockable, nullptr);
+      } else {
+        owner |= Lockable::kKernelOwnedBit;
+        SetLockOwner(lockable, tcb);
+        UpdateInheritedPriority(tcb);
       }
+      lockable.m_state.store(owner, std::memory_order_relaxed);
+    } else {
+      SetLockOwner(lockable, nullptr);
+      lockable.m_state.store(0, std::memory_order_relaxed);
     }
 
-    m_mcu->TriggerPendSV();
+    // The previous owner may still inherit priority from the
+    // waiters of other resources it holds
+    UpdateInheritedPriority(blocker_task);
+
+    RequestContextSwitch();
   }
 }
 
@@ -214,31 +439,39 @@ __WEAK void Kernel::TriggerSchedulerExitHook() { }
 
 void Kernel::TriggerScheduler() {
   TriggerSchedulerEntryHook();
-  uint64_t num_ticks = GetTicks();
 
+  if (m_ticks_suppressed) {
+    // Scheduling before the end of the idle period. Catch up
+    // with the time spent idle and wake up the tasks that are due.
+    if (ExitTicklessIdle() > 0) {
+      CheckTaskNeedsAwakening();
+    }
+  }
+
+  // A preempted task stays at the head of its ready queue, so it
+  // resumes with the rest of its time slice once the higher priority
+  // tasks are done. Rotation only happens in UpdateTimeSlice.
   if (m_current_task &&
       m_current_task->state == task_state::RUNNING) {
     m_current_task->state = task_state::READY;
-    m_current_task->run_last_timestamp = num_ticks;
   }
 
-  // Select next task based on priority
-  m_current_task = nullptr;
-  task_control_block* tcb = nullptr;
-  LinkedList_WalkEntry(m_ready_list, tcb, list) {
-    if (tcb->state == task_state::READY) {
-      if (!m_current_task || (tcb->priority > m_current_task->priority)) {
-        m_current_task = tcb;
-      } else if ((tcb->priority == m_current_task->priority) &&
-                 (tcb->run_last_timestamp < m_current_task->run_last_timestamp)) {
-        m_current_task = tcb;
-      }
-    }
-  }
+  // Select next task based on the scheduling policy
+  task_control_block* previous_task = m_current_task;
+  m_current_task = m_scheduler.GetNextTask();
 
   ATE_ASSERT(m_current_task != nullptr);
   m_current_task->state = task_state::RUNNING;
 
+  if constexpr (STACK_GUARD_SIZE > 0) {
+    // The guard stays in place when the same task keeps running
+    if (m_current_task != previous_task) {
+      m_mcu->SetStackGuard(m_current_task->stack_guard);
+    }
+  }
+
+  EnterTicklessIdle();
+
   TriggerSchedulerExitHook();
 }
 
@@ -247,26 +480,157 @@ void Kernel::TriggerScheduler_Static() {
 }
 
 void Kernel::CheckTaskNeedsAwakening() {
-  task_control_block* tcb = nullptr;
-  task_control_block* next_tcb = nullptr;
+  // Sleeping tasks are ordered by wake up time, so only the head
+  // of the list needs to be checked. Stop at the first task that
+  // is not due yet.
+  while (!m_sleeping_list.Empty()) {
+    auto* tcb = m_sleeping_list.Front();
+    if (m_ticks < tcb->blockArgument.timestamp) {
+      break;
+    }
 
-  LinkedList_WalkEntry_Safe(m_sleeping_list, tcb, next_tcb, list) {
-    // Resume task if asleep
-    if (m_ticks >= tcb->blockArgument.timestamp) {
-      tcb->state = task_state::READY;
-      LinkedList_RemoveEntry(m_sleeping_list, tcb, list);
-      LinkedList_AddEntry(m_ready_list, tcb, list);
+    m_sleeping_list.Remove(tcb);
+    tcb->state = task_state::READY;
+    m_scheduler.AddReadyTask(tcb);
+  }
+}
+
+void Kernel::SetLockOwner(Lockable& lockable, task_control_block* tcb) {
+  auto *owner = lockable.GetBlockerTask();
+  if (owner) {
+    owner->held_locks.Remove(&lockable.m_held_node);
+  }
+  if (tcb) {
+    tcb->held_locks.PushBack(&lockable.m_held_node);
+  }
+  lockable.SetBlockerTask(tcb);
+}
+
+Priority Kernel::GetInheritedPriority(const task_control_block* tcb) const {
+  Priority priority = std::max(tcb->base_priority, tcb->ceiling);
+
+  for (auto *node : tcb->held_locks) {
+    auto *waiter = node->lockable->m_waiters.Front();
+    if (waiter && (waiter->priority > priority)) {
+      priority = waiter->priority;
+    }
+  }
+  return priority;
+}
+
+void Kernel::UpdateInheritedPriority(task_control_block* tcb) {
+  while (tcb) {
+    Priority priority = GetInheritedPriority(tcb);
+    if (priority == tcb->priority) {
+      return;
+    }
+
+    if (tcb->state != task_state::BLOCKED) {
+      SetTaskPriority(tcb, priority);
+      return;
+    }
+
+    // A blocked task keeps its place in the waiters of the resource
+    // it waits for, and the change is propagated to the owner.
+    auto *lockable = tcb->blockArgument.lockable;
+    lockable->m_waiters.Remove(tcb);
+    tcb->priority = priority;
+    lockable->m_waiters.Insert(tcb, HasHigherPriority);
+    tcb = lockable->GetBlockerTask();
+  }
+}
+
+Priority Kernel::RaiseCeiling(Priority ceiling) {
+  CriticalSection s;
+  task_control_block* tcb = m_current_task;
+  ATE_ASSERT(tcb->base_priority <= ceiling);
+
+  Priority saved_ceiling = tcb->ceiling;
+  if (saved_ceiling < ceiling) {
+    tcb->ceiling = ceiling;
+    if (tcb->priority < ceiling) {
+      SetTaskPriority(tcb, ceiling);
     }
   }
+  return saved_ceiling;
+}
+
+void Kernel::RestoreCeiling(Priority ceiling) {
+  CriticalSection s;
+  m_current_task->ceiling = ceiling;
+  UpdateInheritedPriority(m_current_task);
+
+  // Tasks that became ready while the ceiling was raised
+  // can preempt the current task now
+  RequestContextSwitch();
+}
+
+void Kernel::RequestContextSwitch(bool voluntary) {
+  bool running = (m_current_task != nullptr) &&
+                 (m_current_task->state == task_state::RUNNING);
+  bool keep_running = (!Scheduler::kPreemptive && !voluntary) ||
+                      (m_scheduler.GetNextTask() == m_current_task);
+  if (running && keep_running) {
+    // The scheduler would keep the running task, save the switch
+    m_skipped_context_switches++;
+    EnterTicklessIdle();
+    return;
+  }
+
+  m_mcu->TriggerPendSV();
+}
+
+void Kernel::EnterTicklessIdle() {
+  if (!m_tickless_idle || m_ticks_suppressed ||
+      !m_scheduler.IsOnlyIdleReady()) {
+    return;
+  }
+
+  // Idle until the first sleeping task is due or for as long as the
+  // timer allows if there is none.
+  uint32_t idle_ticks = UINT32_MAX;
+  if (!m_sleeping_list.Empty()) {
+    auto* tcb = m_sleeping_list.Front();
+    uint64_t wake_up = tcb->blockArgument.timestamp;
+    uint64_t remaining = (wake_up > m_ticks) ? wake_up - m_ticks : 0;
+    idle_ticks = remaining < UINT32_MAX ? remaining : UINT32_MAX;
+  }
+
+  m_ticks_suppressed = m_mcu->SuppressTicks(idle_ticks) > 0;
+}
+
+uint32_t Kernel::ExitTicklessIdle() {
+  m_ticks_suppressed = false;
+  uint32_t elapsed_ticks = m_mcu->RestoreTicks();
+
+  CriticalSection s;
+  m_ticks += elapsed_ticks;
+  return elapsed_ticks;
+}
+
+void Kernel::UpdateTimeSlice() {
+  // A task holding a ceiling mutex is not rotated,
+  // its peers might share the mutex.
+  task_control_block* tcb = m_current_task;
+  if (!tcb || (tcb->state != task_state::RUNNING) ||
+      (tcb->ceiling != Priority::IDLE)) {
+    return;
+  }
+
+  m_scheduler.ConsumeTimeSlice(tcb);
 }
 
 void Kernel::HandleTick() {
-  {
+  if (m_ticks_suppressed) {
+    // End of the idle period
+    ExitTicklessIdle();
+  } else {
     CriticalSection s;
     m_ticks++;
   }
   CheckTaskNeedsAwakening();
-  m_mcu->TriggerPendSV();
+  UpdateTimeSlice();
+  RequestContextSwitch();
 }
 
 Kernel::Kernel(Hw::MCU* mcu) :
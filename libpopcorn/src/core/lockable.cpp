@@ -20,8 +20,29 @@
 
 #include "popcorn/core/lockable.h"
 #include "popcorn/API/syscall.h"
+#include "popcorn/core/kernel.h"
 
 namespace Popcorn {
+extern Kernel* g_kernel;
+
+// Both compile to a LDREX/STREX loop on the owner word. An exception
+// in between clears the exclusive monitor, so a kernel update of the
+// word can not be missed.
+bool Lockable::TryAcquire() {
+  auto self = reinterpret_cast<std::uintptr_t>(g_kernel->GetCurrentTask());
+  std::uintptr_t expected = 0;
+  return m_state.compare_exchange_strong(expected, self,
+                                         std::memory_order_acquire,
+                                         std::memory_order_relaxed);
+}
+
+bool Lockable::TryRelease() {
+  auto self = reinterpret_cast<std::uintptr_t>(g_kernel->GetCurrentTask());
+  std::uintptr_t expected = self;
+  return m_state.compare_exchange_strong(expected, 0,
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed);
+}
 
 void Lockable::Block() {
   Syscall::Instance().Wait(*this);
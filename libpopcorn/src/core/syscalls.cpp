@@ -25,6 +25,7 @@
 #include "popcorn/core/kernel.h"
 
 using std::uint32_t;
+using std::uintptr_t;
 
 
 namespace Popcorn {
@@ -45,7 +46,27 @@ namespace Popcorn {
 
   void Syscall::CreateTask(task_func func, void* arg, Priority priority,
                            const char* name, uint32_t stack_size) {
-    Hw::MCU::SupervisorCall<SyscallIdx::CreateTask>();
+    Hw::create_task_args args = { func, arg, priority, name, stack_size };
+    Hw::MCU::SupervisorCall<SyscallIdx::CreateTask>(
+      reinterpret_cast<uintptr_t>(&args));
+  }
+
+  void Syscall::CreateTaskStatic(task_func func, void* arg,
+                                 const static_task_params& params) {
+    Hw::MCU::SupervisorCall<SyscallIdx::CreateTaskStatic>(
+      reinterpret_cast<uintptr_t>(func), reinterpret_cast<uintptr_t>(arg),
+      reinterpret_cast<uintptr_t>(&params));
+  }
+
+  void Syscall::CreatePeriodicTask(task_func func, void* arg,
+                                   const periodic_task_params& params) {
+    Hw::MCU::SupervisorCall<SyscallIdx::CreatePeriodicTask>(
+      reinterpret_cast<uintptr_t>(func), reinterpret_cast<uintptr_t>(arg),
+      reinterpret_cast<uintptr_t>(&params));
+  }
+
+  void Syscall::WaitForNextPeriod() {
+    Hw::MCU::SupervisorCall<SyscallIdx::WaitForNextPeriod>();
   }
 
   void Syscall::DestroyTask() {
@@ -53,19 +74,21 @@ namespace Popcorn {
   }
 
   void Syscall::Sleep(uint32_t ticks) {
-    Hw::MCU::SupervisorCall<SyscallIdx::Sleep>();
+    Hw::MCU::SupervisorCall<SyscallIdx::Sleep>(ticks);
   }
 
   void Syscall::Yield() {
     Hw::MCU::SupervisorCall<SyscallIdx::Yield>();
   }
 
-  void Syscall::Wait(const Lockable& lockable) {
-    Hw::MCU::SupervisorCall<SyscallIdx::Wait>();
+  void Syscall::Wait(Lockable& lockable) {
+    Hw::MCU::SupervisorCall<SyscallIdx::Wait>(
+      reinterpret_cast<uintptr_t>(&lockable));
   }
 
   void Syscall::Lock(Lockable& lockable, bool acquired) {
-    Hw::MCU::SupervisorCall<SyscallIdx::Lock>();
+    Hw::MCU::SupervisorCall<SyscallIdx::Lock>(
+      reinterpret_cast<uintptr_t>(&lockable), acquired);
   }
 
   void Syscall::RegisterError() {
@@ -21,24 +21,23 @@
 #include "popcorn/primitives/mutex.h"
 
 namespace Popcorn {
-Mutex::Mutex() {
-  m_held.clear();
-}
-
 void Mutex::Lock() {
-  bool was_already_held = m_held.test_and_set();
-
-  // If the lock wasn't available
-  // try again after blocking the task
-  while (was_already_held) {
-    Block();
-    was_already_held = m_held.test_and_set();
+  // Uncontended locks never enter the kernel
+  if (TryAcquire()) {
+    return;
   }
-  LockAcquired();
+
+  // The kernel hands the lock over to us before
+  // waking us up, there is no need to try again
+  Block();
 }
 
 void Mutex::Unlock() {
-  m_held.clear();
+  if (TryRelease()) {
+    return;
+  }
+
+  // Ownership is passed to the next waiter by the kernel
   LockReleased();
 }
 
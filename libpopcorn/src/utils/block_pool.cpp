@@ -0,0 +1,60 @@
+/*
+ * This file is part of Popcorn
+ * Copyright (c) 2020 Javier Alvarez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+#include "popcorn/utils/block_pool.h"
+
+#include "popcorn/primitives/critical_section.h"
+#include "popcorn/platform.h"
+
+namespace Popcorn {
+void* BlockPool::Allocate() {
+  CriticalSection s;
+
+  void* block = nullptr;
+  if (m_free_list != nullptr) {
+    block = m_free_list;
+    m_free_list = m_free_list->next;
+  } else if (m_untouched < m_num_blocks) {
+    block = &m_memory[m_untouched * m_block_size];
+    m_untouched++;
+  } else {
+    return nullptr;
+  }
+
+  m_used_blocks++;
+  return block;
+}
+
+void BlockPool::Free(void* block) {
+  ATE_ASSERT(Contains(block));
+
+  CriticalSection s;
+  auto* node = reinterpret_cast<free_block*>(block);
+  node->next = m_free_list;
+  m_free_list = node;
+  m_used_blocks--;
+}
+
+bool BlockPool::Contains(const void* ptr) const {
+  auto* byte_ptr = reinterpret_cast<const std::uint8_t*>(ptr);
+  return (byte_ptr >= m_memory) &&
+         (byte_ptr < &m_memory[m_num_blocks * m_block_size]);
+}
+}  // namespace Popcorn
@@ -0,0 +1,90 @@
+/*
+ * This file is part of Popcorn
+ * Copyright (c) 2020 Javier Alvarez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+#include "popcorn/utils/heap_tracker.h"
+
+#include "popcorn/platform.h"
+
+namespace Popcorn {
+void HeapTracker::RecordAllocation(std::size_t block_size) {
+  m_bytes_in_use += block_size;
+  m_allocations++;
+  if (m_bytes_in_use > m_high_watermark) {
+    m_high_watermark = m_bytes_in_use;
+  }
+}
+
+void HeapTracker::RecordFree(std::size_t block_size) {
+  ATE_ASSERT((m_bytes_in_use >= block_size) && (m_allocations > 0));
+  m_bytes_in_use -= block_size;
+  m_allocations--;
+}
+
+void* HeapTracker::Tag(void* block, std::size_t offset, std::size_t size,
+                       const void* owner, const void* site) {
+  ATE_ASSERT(offset >= kTagSize);
+  void* ptr = reinterpret_cast<std::uint8_t*>(block) + offset;
+  allocation_tag* tag = TagOf(ptr);
+  tag->list = {};
+  tag->owner = owner;
+  tag->site = site;
+  tag->size = static_cast<std::uint32_t>(size);
+  tag->offset = static_cast<std::uint32_t>(offset);
+  m_tags.PushBack(tag);
+  return ptr;
+}
+
+void* HeapTracker::Untag(void* ptr) {
+  allocation_tag* tag = TagOf(ptr);
+  m_tags.Remove(tag);
+  return reinterpret_cast<std::uint8_t*>(ptr) - tag->offset;
+}
+
+allocation_tag* HeapTracker::TagOf(const void* ptr) {
+  auto address = reinterpret_cast<std::uintptr_t>(ptr);
+  return reinterpret_cast<allocation_tag*>(address - kTagSize);
+}
+
+std::size_t HeapTracker::UsageOf(const void* owner) const {
+  std::size_t usage = 0;
+  for (const allocation_tag* tag : m_tags) {
+    if (tag->owner == owner) {
+      usage += tag->size;
+    }
+  }
+  return usage;
+}
+
+std::size_t HeapTracker::ReportLeaks(const void* owner) const {
+  std::size_t leaks = 0;
+  for (const allocation_tag* tag : m_tags) {
+    if (tag->owner == owner) {
+      auto address = reinterpret_cast<std::uintptr_t>(tag) + kTagSize;
+      App_HeapLeak_Hook(owner, reinterpret_cast<const void*>(address),
+                        tag->size, tag->site);
+      leaks++;
+    }
+  }
+  return leaks;
+}
+}  // namespace Popcorn
+
+__WEAK void App_HeapLeak_Hook(const void* owner, const void* ptr,
+                              std::size_t size, const void* site) { }
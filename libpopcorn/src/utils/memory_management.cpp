@@ -18,26 +18,327 @@
 // This is an open source non-commercial project. Dear PVS-Studio, please check it.
 // PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
 
-#include <stdlib.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
 
 #include "popcorn/utils/memory_management.h"
-#include "popcorn/primitives/spinlock.h"
-#include "popcorn/primitives/unique_lock.h"
+#include "popcorn/utils/block_pool.h"
+#include "popcorn/utils/heap_tracker.h"
+#include "popcorn/utils/tlsf.h"
+#include "popcorn/core/kernel.h"
+#include "popcorn/primitives/critical_section.h"
+#include "popcorn/os_config.h"
 #include "popcorn/platform.h"
 
-using Popcorn::SpinLock;
-using Popcorn::UniqueLock;
+using Popcorn::BlockPool;
+using Popcorn::CriticalSection;
+using Popcorn::HeapTracker;
+using Popcorn::allocation_tag;
+using Popcorn::Kernel;
+using Popcorn::Tlsf;
 
-static SpinLock lock;
+namespace Popcorn {
+extern Kernel* g_kernel;
+}  // namespace Popcorn
+
+using Popcorn::g_kernel;
+
+namespace {
+constexpr std::size_t kNumPools = std::size(MEMORY_POOL_CLASSES);
+
+constexpr std::size_t PoolArenaSize() {
+  std::size_t size = 0;
+  for (const auto& pool_class : MEMORY_POOL_CLASSES) {
+    size += pool_class.block_size * pool_class.num_blocks;
+  }
+  return size;
+}
+
+constexpr bool ArePoolClassesValid() {
+  std::uint32_t previous_size = 0;
+  for (const auto& pool_class : MEMORY_POOL_CLASSES) {
+    if ((pool_class.block_size <= previous_size) ||
+        (pool_class.block_size % 8 != 0)) {
+      return false;
+    }
+    previous_size = pool_class.block_size;
+  }
+  return true;
+}
+static_assert(ArePoolClassesValid(),
+              "Pool block sizes must be multiples of 8 in ascending order");
+
+alignas(8) std::uint8_t s_arena[PoolArenaSize()];
+
+constexpr std::array<BlockPool, kNumPools> CreatePools() {
+  std::array<BlockPool, kNumPools> pools = {};
+  std::size_t offset = 0;
+  for (std::size_t i = 0; i < kNumPools; i++) {
+    const auto& pool_class = MEMORY_POOL_CLASSES[i];
+    pools[i] = BlockPool(&s_arena[offset], pool_class.block_size,
+                         pool_class.num_blocks);
+    offset += pool_class.block_size * pool_class.num_blocks;
+  }
+  return pools;
+}
+
+constinit std::array<BlockPool, kNumPools> s_pools = CreatePools();
+
+BlockPool* FindPool(const void* ptr) {
+  for (auto& pool : s_pools) {
+    if (pool.Contains(ptr)) {
+      return &pool;
+    }
+  }
+  return nullptr;
+}
+
+alignas(Tlsf::kAlignment) std::uint8_t s_heap[TLSF_HEAP_SIZE];
+constinit Tlsf s_tlsf { s_heap, sizeof(s_heap) };
+
+constexpr bool kUseTlsf = MEMORY_ALLOCATOR == MemoryAllocator::TLSF;
+
+// Backends. Callers must hold a critical section.
+
+void* Allocate(size_t size) {
+  if constexpr (kUseTlsf) {
+    return s_tlsf.Allocate(size);
+  } else {
+    // Take the smallest block that fits, falling back
+    // to larger classes when a class is exhausted.
+    for (auto& pool : s_pools) {
+      if (pool.BlockSize() < size) {
+        continue;
+      }
+
+      void* ptr = pool.Allocate();
+      if (ptr != nullptr) {
+        return ptr;
+      }
+    }
+    return nullptr;
+  }
+}
+
+void* AllocateAligned(size_t alignment, size_t size) {
+  if constexpr (kUseTlsf) {
+    return s_tlsf.AllocateAligned(alignment, size);
+  } else {
+    // Pool blocks are only guaranteed to be 8 byte aligned
+    if (alignment > 8) {
+      return nullptr;
+    }
+    return Allocate(size);
+  }
+}
+
+void Free(void* block) {
+  if constexpr (kUseTlsf) {
+    s_tlsf.Free(block);
+  } else {
+    BlockPool* pool = FindPool(block);
+    // Not allocated by OsMalloc
+    ATE_ASSERT(pool != nullptr);
+    if (pool != nullptr) {
+      pool->Free(block);
+    }
+  }
+}
+
+void* Reallocate(void* block, size_t size) {
+  if constexpr (kUseTlsf) {
+    return s_tlsf.Reallocate(block, size);
+  } else {
+    BlockPool* pool = FindPool(block);
+    if (pool == nullptr) {
+      // Not allocated by OsMalloc
+      ATE_ASSERT(false);
+      return nullptr;
+    }
+    if (size <= pool->BlockSize()) {
+      return block;
+    }
+
+    void* new_block = Allocate(size);
+    if (new_block != nullptr) {
+      std::memcpy(new_block, block, pool->BlockSize());
+      pool->Free(block);
+    }
+    return new_block;
+  }
+}
+
+size_t BlockSize(const void* block) {
+  if constexpr (kUseTlsf) {
+    return s_tlsf.BlockSize(block);
+  } else {
+    const BlockPool* pool = FindPool(block);
+    return (pool != nullptr) ? pool->BlockSize() : 0;
+  }
+}
+
+// Instrumentation, see HEAP_STATISTICS and HEAP_LEAK_TRACKING
+
+constexpr bool kInstrumented = HEAP_STATISTICS || HEAP_LEAK_TRACKING;
+constexpr size_t kTagSize = HEAP_LEAK_TRACKING ? HeapTracker::kTagSize : 0;
+
+constinit HeapTracker s_tracker;
+
+const void* CurrentOwner() {
+  if constexpr (HEAP_LEAK_TRACKING) {
+    return (g_kernel != nullptr) ? g_kernel->GetCurrentTask() : nullptr;
+  } else {
+    return nullptr;
+  }
+}
+
+void* OnAllocated(void* block, size_t offset, size_t size,
+                  const void* owner, const void* site) {
+  if constexpr (kInstrumented) {
+    if (block == nullptr) {
+      return nullptr;
+    }
+    if constexpr (HEAP_STATISTICS) {
+      s_tracker.RecordAllocation(BlockSize(block));
+    }
+    if constexpr (HEAP_LEAK_TRACKING) {
+      return s_tracker.Tag(block, offset, size, owner, site);
+    }
+  }
+  return block;
+}
+
+void* OnFreeing(void* ptr) {
+  void* block = ptr;
+  if constexpr (HEAP_LEAK_TRACKING) {
+    block = s_tracker.Untag(ptr);
+  }
+  if constexpr (HEAP_STATISTICS) {
+    s_tracker.RecordFree(BlockSize(block));
+  }
+  return block;
+}
+}  // namespace
 
 CLINKAGE void* OsMalloc(size_t size) {
-  // TODO(javier_varez): Migrate to custom allocation scheme
-  UniqueLock<SpinLock> l(lock);
-  void* ptr = malloc(size);
-  return ptr;
+  CriticalSection s;
+  void* block = Allocate(size + kTagSize);
+  return OnAllocated(block, kTagSize, size, CurrentOwner(),
+                     __builtin_return_address(0));
+}
+
+CLINKAGE void* OsAlignedAlloc(size_t alignment, size_t size) {
+  // The tag is placed right before the aligned allocation
+  size_t offset = 0;
+  if constexpr (HEAP_LEAK_TRACKING) {
+    offset = (alignment > kTagSize) ? alignment : kTagSize;
+  }
+
+  CriticalSection s;
+  void* block = AllocateAligned(alignment, size + offset);
+  return OnAllocated(block, offset, size, CurrentOwner(),
+                     __builtin_return_address(0));
+}
+
+CLINKAGE void* OsRealloc(void* ptr, size_t size) {
+  if (ptr == nullptr) {
+    CriticalSection s;
+    void* block = Allocate(size + kTagSize);
+    return OnAllocated(block, kTagSize, size, CurrentOwner(),
+                       __builtin_return_address(0));
+  }
+  if (size == 0) {
+    OsFree(ptr);
+    return nullptr;
+  }
+
+  CriticalSection s;
+  if constexpr (kInstrumented) {
+    size_t offset = 0;
+    size_t old_size = 0;
+    const void* owner = nullptr;
+    const void* old_site = nullptr;
+    if constexpr (HEAP_LEAK_TRACKING) {
+      const allocation_tag* tag = HeapTracker::TagOf(ptr);
+      offset = tag->offset;
+      old_size = tag->size;
+      owner = tag->owner;
+      old_site = tag->site;
+    }
+
+    // The block may move, so it is untracked while resized
+    void* block = OnFreeing(ptr);
+    void* new_block = Reallocate(block, size + offset);
+    if (new_block == nullptr) {
+      OnAllocated(block, offset, old_size, owner, old_site);
+      return nullptr;
+    }
+    return OnAllocated(new_block, offset, size, owner,
+                       __builtin_return_address(0));
+  } else {
+    return Reallocate(ptr, size);
+  }
 }
 
 CLINKAGE void OsFree(void* ptr) {
-  UniqueLock<SpinLock> l(lock);
-  free(ptr);
+  if (ptr == nullptr) {
+    return;
+  }
+
+  CriticalSection s;
+  Free(OnFreeing(ptr));
+}
+
+CLINKAGE void OsGetHeapStatistics(heap_statistics* stats) {
+  CriticalSection s;
+  if constexpr (HEAP_STATISTICS) {
+    stats->bytes_in_use = s_tracker.BytesInUse();
+    stats->high_watermark = s_tracker.HighWatermark();
+    stats->allocations = s_tracker.Allocations();
+  } else {
+    stats->bytes_in_use = 0;
+    stats->high_watermark = 0;
+    stats->allocations = 0;
+  }
+
+  if constexpr (kUseTlsf) {
+    stats->free_bytes = s_tlsf.FreeBytes();
+    stats->largest_free_block = s_tlsf.LargestFreeBlock();
+  } else {
+    stats->free_bytes = 0;
+    stats->largest_free_block = 0;
+    for (const auto& pool : s_pools) {
+      stats->free_bytes += pool.FreeBlocks() * pool.BlockSize();
+      if (pool.FreeBlocks() != 0) {
+        stats->largest_free_block = pool.BlockSize();
+      }
+    }
+  }
+}
+
+CLINKAGE size_t OsGetHeapUsage(const void* owner) {
+  if constexpr (HEAP_LEAK_TRACKING) {
+    CriticalSection s;
+    return s_tracker.UsageOf(owner);
+  } else {
+    return 0;
+  }
+}
+
+CLINKAGE void OsSetHeapOwner(void* ptr, const void* owner) {
+  if constexpr (HEAP_LEAK_TRACKING) {
+    HeapTracker::TagOf(ptr)->owner = owner;
+  }
+}
+
+CLINKAGE size_t OsReportHeapLeaks(const void* owner) {
+  if constexpr (HEAP_LEAK_TRACKING) {
+    CriticalSection s;
+    return s_tracker.ReportLeaks(owner);
+  } else {
+    return 0;
+  }
 }
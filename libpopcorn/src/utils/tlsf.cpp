@@ -0,0 +1,370 @@
+/*
+ * This file is part of Popcorn
+ * Copyright (c) 2020 Javier Alvarez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+#include "popcorn/utils/tlsf.h"
+
+#include <cstring>
+
+#include "popcorn/platform.h"
+
+namespace Popcorn {
+namespace {
+std::uint32_t FindLastSet(std::size_t value) {
+  return 31 - __builtin_clz(static_cast<std::uint32_t>(value));
+}
+
+std::uint32_t FindFirstSet(std::uint32_t value) {
+  return __builtin_ctz(value);
+}
+}  // namespace
+
+std::size_t Tlsf::AlignUp(std::size_t value, std::size_t alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+std::size_t Tlsf::Size(const block_header* block) {
+  return block->size & ~static_cast<std::size_t>(1);
+}
+
+bool Tlsf::IsFree(const block_header* block) {
+  return (block->size & 1U) != 0;
+}
+
+void* Tlsf::Payload(block_header* block) {
+  return reinterpret_cast<std::uint8_t*>(block) + kHeaderSize;
+}
+
+Tlsf::block_header* Tlsf::FromPayload(const void* ptr) {
+  auto* byte_ptr = const_cast<std::uint8_t*>(
+    reinterpret_cast<const std::uint8_t*>(ptr));
+  return reinterpret_cast<block_header*>(byte_ptr - kHeaderSize);
+}
+
+Tlsf::block_header* Tlsf::NextPhys(const block_header* block) {
+  auto* byte_ptr = const_cast<std::uint8_t*>(
+    reinterpret_cast<const std::uint8_t*>(block));
+  return reinterpret_cast<block_header*>(byte_ptr + kHeaderSize +
+                                         Size(block));
+}
+
+Tlsf::free_links* Tlsf::Links(block_header* block) {
+  return reinterpret_cast<free_links*>(Payload(block));
+}
+
+std::size_t Tlsf::AdjustSize(std::size_t size) {
+  size = AlignUp(size, kAlignment);
+  return size < kMinBlockSize ? kMinBlockSize : size;
+}
+
+void Tlsf::Mapping(std::size_t size, std::uint32_t* fl, std::uint32_t* sl) {
+  if (size < kSmallBlockSize) {
+    *fl = 0;
+    *sl = static_cast<std::uint32_t>(size / kAlignment);
+  } else {
+    std::uint32_t msb = FindLastSet(size);
+    *sl = static_cast<std::uint32_t>(size >> (msb - kSlIndexShift)) ^ kSlCount;
+    *fl = msb - (kFlIndexShift - 1);
+  }
+}
+
+void Tlsf::MappingSearch(std::size_t size, std::uint32_t* fl,
+                         std::uint32_t* sl) {
+  // Round up to the next list, so that any block in it fits the request
+  if (size >= kSmallBlockSize) {
+    size += (static_cast<std::size_t>(1) <<
+             (FindLastSet(size) - kSlIndexShift)) - 1;
+  }
+  Mapping(size, fl, sl);
+}
+
+void Tlsf::EnsureInitialized() {
+  if (m_initialized) {
+    return;
+  }
+  m_initialized = true;
+
+  ATE_ASSERT(reinterpret_cast<std::uintptr_t>(m_memory) % kAlignment == 0);
+  std::size_t size = m_size & ~(kAlignment - 1);
+  if (size < 2 * kHeaderSize + kMinBlockSize) {
+    return;
+  }
+
+  std::size_t payload = size - 2 * kHeaderSize;
+  if (payload >= kMaxBlockSize) {
+    payload = kMaxBlockSize - kAlignment;
+  }
+
+  // A single free block followed by a used sentinel of size 0, which
+  // stops merges at the end of the heap
+  auto* block = reinterpret_cast<block_header*>(m_memory);
+  block->prev_phys = nullptr;
+  SetSize(block, payload, true);
+  block_header* sentinel = NextPhys(block);
+  sentinel->prev_phys = block;
+  SetSize(sentinel, 0, false);
+  InsertFreeBlock(block);
+}
+
+Tlsf::block_header* Tlsf::FindSuitableBlock(std::size_t size) {
+  std::uint32_t fl;
+  std::uint32_t sl;
+  MappingSearch(size, &fl, &sl);
+  if (fl >= kFlCount) {
+    return nullptr;
+  }
+
+  std::uint32_t sl_map = m_sl_bitmap[fl] & (~0U << sl);
+  if (sl_map == 0) {
+    std::uint32_t fl_map = m_fl_bitmap & (~0U << (fl + 1));
+    if (fl_map == 0) {
+      return nullptr;
+    }
+    fl = FindFirstSet(fl_map);
+    sl_map = m_sl_bitmap[fl];
+  }
+  sl = FindFirstSet(sl_map);
+  return m_free_lists[fl][sl];
+}
+
+void Tlsf::InsertFreeBlock(block_header* block) {
+  std::uint32_t fl;
+  std::uint32_t sl;
+  Mapping(Size(block), &fl, &sl);
+
+  block_header*& head = m_free_lists[fl][sl];
+  free_links* links = Links(block);
+  links->prev = nullptr;
+  links->next = head;
+  if (head != nullptr) {
+    Links(head)->prev = block;
+  }
+  head = block;
+
+  m_sl_bitmap[fl] |= 1U << sl;
+  m_fl_bitmap |= 1U << fl;
+  m_free_bytes += Size(block);
+}
+
+void Tlsf::RemoveFreeBlock(block_header* block) {
+  std::uint32_t fl;
+  std::uint32_t sl;
+  Mapping(Size(block), &fl, &sl);
+
+  free_links* links = Links(block);
+  if (links->prev != nullptr) {
+    Links(links->prev)->next = links->next;
+  } else {
+    m_free_lists[fl][sl] = links->next;
+  }
+  if (links->next != nullptr) {
+    Links(links->next)->prev = links->prev;
+  }
+
+  if (m_free_lists[fl][sl] == nullptr) {
+    m_sl_bitmap[fl] &= ~(1U << sl);
+    if (m_sl_bitmap[fl] == 0) {
+      m_fl_bitmap &= ~(1U << fl);
+    }
+  }
+  m_free_bytes -= Size(block);
+}
+
+void Tlsf::SetSize(block_header* block, std::size_t size, bool free) {
+  block->size = size | (free ? 1U : 0U);
+}
+
+Tlsf::block_header* Tlsf::Split(block_header* block, std::size_t size) {
+  auto* remaining = reinterpret_cast<block_header*>(
+    reinterpret_cast<std::uint8_t*>(Payload(block)) + size);
+  remaining->prev_phys = block;
+  SetSize(remaining, Size(block) - size - kHeaderSize, true);
+  NextPhys(remaining)->prev_phys = remaining;
+  SetSize(block, size, IsFree(block));
+  return remaining;
+}
+
+Tlsf::block_header* Tlsf::MergeWithNext(block_header* block) {
+  block_header* next = NextPhys(block);
+  SetSize(block, Size(block) + kHeaderSize + Size(next), IsFree(block));
+  NextPhys(block)->prev_phys = block;
+  return block;
+}
+
+void Tlsf::TrimUsed(block_header* block, std::size_t size) {
+  if (Size(block) < size + kHeaderSize + kMinBlockSize) {
+    return;
+  }
+
+  block_header* remaining = Split(block, size);
+  block_header* next = NextPhys(remaining);
+  if (IsFree(next)) {
+    RemoveFreeBlock(next);
+    MergeWithNext(remaining);
+  }
+  InsertFreeBlock(remaining);
+}
+
+void* Tlsf::Allocate(std::size_t size) {
+  EnsureInitialized();
+  if ((size == 0) || (size > kMaxBlockSize)) {
+    return nullptr;
+  }
+
+  std::size_t adjusted = AdjustSize(size);
+  block_header* block = FindSuitableBlock(adjusted);
+  if (block == nullptr) {
+    return nullptr;
+  }
+
+  RemoveFreeBlock(block);
+  SetSize(block, Size(block), false);
+  TrimUsed(block, adjusted);
+  return Payload(block);
+}
+
+void* Tlsf::AllocateAligned(std::size_t alignment, std::size_t size) {
+  ATE_ASSERT((alignment & (alignment - 1)) == 0);
+  if (alignment <= kAlignment) {
+    return Allocate(size);
+  }
+
+  EnsureInitialized();
+  if ((size == 0) || (size > kMaxBlockSize) || (alignment > kMaxBlockSize)) {
+    return nullptr;
+  }
+
+  // Leave room for a leading free block in front of the aligned one
+  constexpr std::size_t kMinGap = kHeaderSize + kMinBlockSize;
+  std::size_t adjusted = AdjustSize(size);
+  block_header* block = FindSuitableBlock(adjusted + alignment + kMinGap);
+  if (block == nullptr) {
+    return nullptr;
+  }
+  RemoveFreeBlock(block);
+
+  auto address = reinterpret_cast<std::uintptr_t>(Payload(block));
+  std::uintptr_t aligned = AlignUp(address, alignment);
+  if ((aligned != address) && (aligned - address < kMinGap)) {
+    aligned = AlignUp(address + kMinGap, alignment);
+  }
+
+  std::size_t gap = aligned - address;
+  if (gap != 0) {
+    // The previous block is never free, as free blocks are always merged
+    auto* aligned_block = reinterpret_cast<block_header*>(aligned - kHeaderSize);
+    aligned_block->prev_phys = block;
+    SetSize(aligned_block, Size(block) - gap, false);
+    NextPhys(aligned_block)->prev_phys = aligned_block;
+    SetSize(block, gap - kHeaderSize, true);
+    InsertFreeBlock(block);
+    block = aligned_block;
+  } else {
+    SetSize(block, Size(block), false);
+  }
+
+  TrimUsed(block, adjusted);
+  return Payload(block);
+}
+
+void* Tlsf::Reallocate(void* ptr, std::size_t size) {
+  if (ptr == nullptr) {
+    return Allocate(size);
+  }
+  if (size == 0) {
+    Free(ptr);
+    return nullptr;
+  }
+  if (size > kMaxBlockSize) {
+    return nullptr;
+  }
+
+  ATE_ASSERT(Contains(ptr));
+  block_header* block = FromPayload(ptr);
+  std::size_t adjusted = AdjustSize(size);
+  if (adjusted > Size(block)) {
+    block_header* next = NextPhys(block);
+    if (IsFree(next) &&
+        (Size(block) + kHeaderSize + Size(next) >= adjusted)) {
+      RemoveFreeBlock(next);
+      MergeWithNext(block);
+    } else {
+      void* new_ptr = Allocate(size);
+      if (new_ptr == nullptr) {
+        return nullptr;
+      }
+      std::memcpy(new_ptr, ptr, Size(block));
+      Free(ptr);
+      return new_ptr;
+    }
+  }
+
+  TrimUsed(block, adjusted);
+  return ptr;
+}
+
+void Tlsf::Free(void* ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+
+  ATE_ASSERT(Contains(ptr));
+  block_header* block = FromPayload(ptr);
+  ATE_ASSERT(!IsFree(block));
+
+  SetSize(block, Size(block), true);
+  block_header* prev = block->prev_phys;
+  if ((prev != nullptr) && IsFree(prev)) {
+    RemoveFreeBlock(prev);
+    block = MergeWithNext(prev);
+  }
+
+  block_header* next = NextPhys(block);
+  if (IsFree(next)) {
+    RemoveFreeBlock(next);
+    MergeWithNext(block);
+  }
+  InsertFreeBlock(block);
+}
+
+bool Tlsf::Contains(const void* ptr) const {
+  auto* byte_ptr = reinterpret_cast<const std::uint8_t*>(ptr);
+  return (byte_ptr >= m_memory) && (byte_ptr < &m_memory[m_size]);
+}
+
+std::size_t Tlsf::BlockSize(const void* ptr) const {
+  return Size(FromPayload(ptr));
+}
+
+std::size_t Tlsf::LargestFreeBlock() const {
+  if (!m_initialized || (FreeBytes() == 0)) {
+    return 0;
+  }
+
+  std::size_t largest = 0;
+  auto* block = reinterpret_cast<const block_header*>(m_memory);
+  while (Size(block) != 0) {
+    if (IsFree(block) && (Size(block) > largest)) {
+      largest = Size(block);
+    }
+    block = NextPhys(block);
+  }
+  return largest;
+}
+}  // namespace Popcorn
@@ -23,15 +23,22 @@ LOCAL_CXXFLAGS := \
 
 LOCAL_SRC := \
     $(TEST_SRC) \
+    $(LOCAL_DIR)/src/allocator_benchmark.cpp \
+    $(LOCAL_DIR)/src/block_pool_test.cpp \
     $(LOCAL_DIR)/src/cortex-m_port_test.cpp \
+    $(LOCAL_DIR)/src/deadline_heap_test.cpp \
+    $(LOCAL_DIR)/src/heap_tracker_test.cpp \
     $(LOCAL_DIR)/src/kernel_test.cpp \
     $(LOCAL_DIR)/src/linked_list_test.cpp \
     $(LOCAL_DIR)/src/mock_assert.cpp \
     $(LOCAL_DIR)/src/mock_mcu.cpp \
     $(LOCAL_DIR)/src/mock_mem_management.cpp \
     $(LOCAL_DIR)/src/mutex_test.cpp \
+    $(LOCAL_DIR)/src/scheduling_policy_test.cpp \
     $(LOCAL_DIR)/src/spinlock_test.cpp \
-    $(LOCAL_DIR)/src/syscall_test.cpp
+    $(LOCAL_DIR)/src/syscall_test.cpp \
+    $(LOCAL_DIR)/src/task_cache_test.cpp \
+    $(LOCAL_DIR)/src/tlsf_test.cpp
 
 LOCAL_LDFLAGS := \
     -lpthread
@@ -29,15 +29,21 @@ class MockKernel : public Popcorn::Kernel {
   MOCK_METHOD(void, CreateTask, (Popcorn::task_func func, void* arg,
                                  Popcorn::Priority priority,
                                  const char* name, std::uint32_t stack_size));
+  MOCK_METHOD(void, CreateTaskStatic, (Popcorn::task_func func, void* arg,
+                                 const Popcorn::static_task_params& params));
+  MOCK_METHOD(void, CreatePeriodicTask, (Popcorn::task_func func, void* arg,
+                                 const Popcorn::periodic_task_params& params));
+  MOCK_METHOD(void, WaitForNextPeriod, ());
   MOCK_METHOD(void, Sleep, (std::uint32_t ticks));
   MOCK_METHOD(void, DestroyTask, ());
   MOCK_METHOD(void, Yield, ());
-  MOCK_METHOD(void, Wait, (const Popcorn::Lockable&));
+  MOCK_METHOD(void, Wait, (Popcorn::Lockable&));
   MOCK_METHOD(void, RegisterError, ());
   MOCK_METHOD(std::uint64_t, GetTicks, ());
   MOCK_METHOD(void, TriggerScheduler, ());
   MOCK_METHOD(void, HandleTick, ());
   MOCK_METHOD(void, Lock, (Popcorn::Lockable&, bool available));
+  MOCK_METHOD(Popcorn::task_control_block*, GetCurrentTask, ());
 };
 
 #endif  // TEST_INC_MOCKKERNEL_H_
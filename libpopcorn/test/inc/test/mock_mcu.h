@@ -25,13 +25,17 @@
 class MockMCU : public Hw::MCU {
  public:
   MockMCU() = default;
-  MOCK_METHOD(void, RegisterSyscallImpl, (Popcorn::ISyscall*));
+  MOCK_METHOD(void, RegisterSyscallImpl, (Popcorn::SyscallImpl*));
   MOCK_METHOD(void, Initialize, (), (const));
   MOCK_METHOD(void, TriggerPendSV, (), (const));
+  MOCK_METHOD(std::uint32_t, SuppressTicks, (std::uint32_t ticks));
+  MOCK_METHOD(std::uint32_t, RestoreTicks, ());
   MOCK_METHOD(uint8_t*, InitializeTask, (uint8_t* stack_top,
                                          Popcorn::task_func func,
                                          void* arg),
                                         (const));
+  MOCK_METHOD(std::uint8_t*, FillMainStack, (std::uint32_t size));
+  MOCK_METHOD(void, SetStackGuard, (std::uintptr_t base), (const));
 };
 
 class MCU_SVC {
@@ -0,0 +1,181 @@
+/*
+ * This file is part of Popcorn
+ * Copyright (c) 2020 Javier Alvarez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Stress benchmark of the heap backends. It is disabled by default, as
+// its results depend on the host. Run it with:
+//   popcorn_test --gtest_also_run_disabled_tests
+//     --gtest_filter=AllocatorBenchmark.*
+
+#include <malloc.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "popcorn/primitives/spinlock.h"
+#include "popcorn/primitives/unique_lock.h"
+#include "popcorn/utils/tlsf.h"
+
+using Popcorn::SpinLock;
+using Popcorn::Tlsf;
+using Popcorn::UniqueLock;
+
+namespace {
+constexpr std::size_t kOperations = 200'000;
+constexpr std::size_t kLiveSlots = 128;
+constexpr std::size_t kMinSize = 8;
+constexpr std::size_t kMaxSize = 1024;
+constexpr std::size_t kHeapSize = 128 * 1024;
+
+struct benchmark_result {
+  std::vector<std::uint32_t> alloc_ns;
+  std::vector<std::uint32_t> free_ns;
+  std::size_t failed_allocations = 0;
+  double fragmentation = 0.0;
+};
+
+std::uint32_t Percentile(std::vector<std::uint32_t>* samples,
+                         double percentile) {
+  if (samples->empty()) {
+    return 0;
+  }
+  std::size_t index = static_cast<std::size_t>(
+    percentile / 100.0 * static_cast<double>(samples->size() - 1));
+  std::nth_element(samples->begin(), samples->begin() + index,
+                   samples->end());
+  return (*samples)[index];
+}
+
+void Report(const char* name, benchmark_result* result) {
+  for (auto* samples : { &result->alloc_ns, &result->free_ns }) {
+    std::printf("%-16s %-6s p50 %6u ns  p99 %6u ns  p99.9 %6u ns  "
+                "max %8u ns\n",
+                name, samples == &result->alloc_ns ? "alloc" : "free",
+                Percentile(samples, 50.0), Percentile(samples, 99.0),
+                Percentile(samples, 99.9), Percentile(samples, 100.0));
+  }
+  std::printf("%-16s failed allocations %zu, fragmentation %.1f%%\n",
+              name, result->failed_allocations,
+              result->fragmentation * 100.0);
+}
+
+std::uint32_t ElapsedNs(std::chrono::steady_clock::time_point start) {
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return static_cast<std::uint32_t>(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+/**
+ * @brief Randomly allocates and frees blocks of random sizes, keeping
+ *        up to kLiveSlots blocks alive. Both allocators see the exact
+ *        same sequence of requests.
+ *
+ * @param sample_fragmentation Called periodically, returns the current
+ *        external fragmentation of the heap.
+ */
+template<typename Alloc, typename Free, typename Fragmentation>
+benchmark_result RunWorkload(Alloc alloc, Free free,
+                     Fragmentation sample_fragmentation) {
+  std::mt19937 rng(0x5EED);
+  std::uniform_int_distribution<std::size_t> slot_dist(0, kLiveSlots - 1);
+  std::uniform_int_distribution<std::size_t> size_dist(kMinSize, kMaxSize);
+
+  benchmark_result result;
+  result.alloc_ns.reserve(kOperations);
+  result.free_ns.reserve(kOperations);
+
+  std::vector<void*> slots(kLiveSlots, nullptr);
+  for (std::size_t i = 0; i < kOperations; i++) {
+    void*& slot = slots[slot_dist(rng)];
+    std::size_t size = size_dist(rng);
+    auto start = std::chrono::steady_clock::now();
+    if (slot != nullptr) {
+      free(slot);
+      result.free_ns.push_back(ElapsedNs(start));
+      slot = nullptr;
+    } else {
+      slot = alloc(size);
+      result.alloc_ns.push_back(ElapsedNs(start));
+      if (slot == nullptr) {
+        result.failed_allocations++;
+      }
+    }
+
+    if (i % 1'000 == 0) {
+      result.fragmentation =
+        std::max(result.fragmentation, sample_fragmentation());
+    }
+  }
+
+  for (void* slot : slots) {
+    free(slot);
+  }
+  return result;
+}
+}  // namespace
+
+TEST(AllocatorBenchmark, DISABLED_LatencyAndFragmentation) {
+  alignas(Tlsf::kAlignment) static std::uint8_t heap_memory[kHeapSize];
+  static Tlsf heap { heap_memory, sizeof(heap_memory) };
+  auto tlsf = RunWorkload(
+    [](std::size_t size) { return heap.Allocate(size); },
+    [](void* ptr) { heap.Free(ptr); },
+    []() {
+      // Share of the free memory that is not usable in a single block
+      if (heap.FreeBytes() == 0) {
+        return 0.0;
+      }
+      return 1.0 - static_cast<double>(heap.LargestFreeBlock()) /
+                   static_cast<double>(heap.FreeBytes());
+    });
+  Report("TLSF", &tlsf);
+
+  // The previous backend: the C library malloc under a SpinLock
+  static SpinLock lock;
+  auto libc = RunWorkload(
+    [](std::size_t size) {
+      UniqueLock<SpinLock> l(lock);
+      return std::malloc(size);
+    },
+    [](void* ptr) {
+      UniqueLock<SpinLock> l(lock);
+      std::free(ptr);
+    },
+    []() {
+#if defined(__GLIBC__) && \
+    ((__GLIBC__ > 2) || ((__GLIBC__ == 2) && (__GLIBC_MINOR__ >= 33)))
+      // Share of the heap held by the C library but not in use
+      struct mallinfo2 info = mallinfo2();
+      if (info.arena == 0) {
+        return 0.0;
+      }
+      return static_cast<double>(info.fordblks) /
+             static_cast<double>(info.arena);
+#else
+      return 0.0;
+#endif
+    });
+  Report("malloc+SpinLock", &libc);
+
+  EXPECT_EQ(tlsf.failed_allocations, 0U);
+}
@@ -0,0 +1,95 @@
+/*
+ * This file is part of Popcorn
+ * Copyright (c) 2020 Javier Alvarez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+#include <cstddef>
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include "popcorn/utils/block_pool.h"
+#include "test/mock_assert.h"
+
+using ::testing::StrictMock;
+using ::testing::_;
+
+using Popcorn::BlockPool;
+
+class BlockPoolTest: public ::testing::Test {
+ protected:
+  static constexpr std::size_t kBlockSize = 32;
+  static constexpr std::size_t kNumBlocks = 4;
+
+  void SetUp() override {
+    g_platform = &platform;
+  }
+
+  void TearDown() override {
+    g_platform = nullptr;
+  }
+
+  std::size_t UntouchedBlocks() const {
+    return pool.m_num_blocks - pool.m_untouched;
+  }
+
+  alignas(8) std::uint8_t memory[kBlockSize * kNumBlocks];
+  BlockPool pool { memory, kBlockSize, kNumBlocks };
+  StrictMock<MockPlatform> platform;
+};
+
+TEST_F(BlockPoolTest, AllocatesEveryBlockThenExhausts) {
+  EXPECT_EQ(pool.BlockSize(), kBlockSize);
+  EXPECT_EQ(pool.FreeBlocks(), kNumBlocks);
+
+  for (std::size_t i = 0; i < kNumBlocks; i++) {
+    void* block = pool.Allocate();
+    EXPECT_EQ(block, &memory[i * kBlockSize]);
+    EXPECT_EQ(pool.FreeBlocks(), kNumBlocks - i - 1);
+  }
+
+  EXPECT_EQ(pool.Allocate(), nullptr);
+  EXPECT_EQ(pool.FreeBlocks(), 0U);
+}
+
+TEST_F(BlockPoolTest, FreedBlocksAreReusedFirst) {
+  void* first = pool.Allocate();
+  void* second = pool.Allocate();
+  EXPECT_EQ(UntouchedBlocks(), kNumBlocks - 2);
+
+  pool.Free(first);
+  pool.Free(second);
+  EXPECT_EQ(pool.FreeBlocks(), kNumBlocks);
+
+  // Recycled blocks come back in LIFO order before touching new ones
+  EXPECT_EQ(pool.Allocate(), second);
+  EXPECT_EQ(pool.Allocate(), first);
+  EXPECT_EQ(UntouchedBlocks(), kNumBlocks - 2);
+  EXPECT_EQ(pool.FreeBlocks(), kNumBlocks - 2);
+}
+
+TEST_F(BlockPoolTest, ContainsOnlyPoolMemory) {
+  EXPECT_TRUE(pool.Contains(&memory[0]));
+  EXPECT_TRUE(pool.Contains(&memory[sizeof(memory) - 1]));
+  EXPECT_FALSE(pool.Contains(&memory[sizeof(memory)]));
+  EXPECT_FALSE(pool.Contains(&platform));
+}
+
+TEST_F(BlockPoolTest, FreeForeignBlockAsserts) {
+  std::uint64_t foreign = 0;
+  EXPECT_CALL(platform, Assert(_));
+  pool.Free(&foreign);
+}
@@ -48,6 +48,8 @@ using Hw::g_SCB;
 using Hw::SCB_t;
 using Hw::g_SysTick;
 using Hw::SysTick_t;
+using Hw::g_MPU;
+using Hw::MPU_t;
 using Hw::MCU;
 
 namespace Hw {
@@ -66,6 +68,7 @@ class MCUTest: public ::testing::Test {
     kernel = make_unique<StrictMock<MockKernel>>(mcu.get());
     g_SCB = &scb;
     g_SysTick = &systick;
+    g_MPU = &mpu;
     g_platform = &platform;
   }
 
@@ -77,6 +80,11 @@ class MCUTest: public ::testing::Test {
     mcu->HandleSVC(frame);
   }
 
+  bool HandleSVC_Static(struct auto_task_stack_frame* frame,
+                        bool from_task) {
+    return MCU::HandleSVC_Static(frame, from_task);
+  }
+
   std::atomic_uint32_t& GetNestedInterruptLevel() {
     return mcu->m_nested_interrupt_level;
   }
@@ -84,25 +92,24 @@ class MCUTest: public ::testing::Test {
   unique_ptr<StrictMock<MockKernel>> kernel;
   SCB_t scb;
   SysTick_t systick;
+  MPU_t mpu;
   unique_ptr<MCUWithLowLevelMock> mcu;
   StrictMock<MockPlatform> platform;
 };
 
-struct SVC_OP {
-  uint8_t immediate;
-  uint8_t opcode;
-
-  explicit SVC_OP(uint8_t i) {
-    immediate = i;
-    opcode = 0xDF;
-  }
-};
+// Registers stacked by a system call, with the number in r12
+auto_task_stack_frame SyscallFrame(SyscallIdx id, uint32_t r0 = 0,
+                                   uint32_t r1 = 0, uint32_t r2 = 0) {
+  auto_task_stack_frame frame {};
+  frame.r0 = r0;
+  frame.r1 = r1;
+  frame.r2 = r2;
+  frame.r12 = static_cast<uint32_t>(id);
+  return frame;
+}
 
 TEST_F(MCUTest, HandleSVC_StartOS_Test) {
-  SVC_OP StartOS_SVC(static_cast<uint8_t>(SyscallIdx::StartOS));
-  struct auto_task_stack_frame frame;
-  frame.pc = (uint32_t)(&StartOS_SVC) + sizeof(uint16_t);
-  frame.xpsr = 0;
+  auto frame = SyscallFrame(SyscallIdx::StartOS);
 
   EXPECT_CALL(*kernel, StartOS()).Times(1).RetiresOnSaturation();
   HandleSVC(&frame);
@@ -110,128 +117,137 @@ TEST_F(MCUTest, HandleSVC_StartOS_Test) {
 
 static void testfunc(void *arg) {}
 
-struct CallStack {
-  auto_task_stack_frame frame;
-  uint32_t data[32];
-};
-
 TEST_F(MCUTest, HandleSVC_CreateTask_Test) {
-  SVC_OP CreateTask_SVC(static_cast<uint8_t>(SyscallIdx::CreateTask));
-  struct CallStack callStack;
-  callStack.frame.pc = (uint32_t)(&CreateTask_SVC) + sizeof(uint16_t);
-  callStack.frame.xpsr = 0;
-
   void* arg = reinterpret_cast<void*>(0xF1F2F3F4);
   constexpr uint32_t stack_size = 123;
   enum Priority prio = Priority::Level_5;
   const char name[] = "FuncName";
 
-  callStack.frame.r1 = (uint32_t)testfunc;
-  callStack.frame.r2 = 0xF1F2F3F4;
-  callStack.frame.r3 = (uint32_t)prio;
-  callStack.data[0] = (uint32_t)name;
-  callStack.data[1] = (uint32_t)stack_size;
+  // The arguments do not fit in registers, they are passed by pointer
+  Hw::create_task_args args = { testfunc, arg, prio, name, stack_size };
+  auto frame = SyscallFrame(SyscallIdx::CreateTask, (uint32_t)&args);
 
-  EXPECT_CALL(*kernel, CreateTask(testfunc, arg, prio, name, stack_size))
+  EXPECT_CALL(*kernel, CreateTask(testfunc, arg, prio, StrEq(name),
+                                  stack_size))
       .Times(1).RetiresOnSaturation();
-  HandleSVC(&callStack.frame);
+  HandleSVC(&frame);
+}
 
-  // Now with aligned stack on entry
-  callStack.frame.xpsr |= 1U << 9;
+TEST_F(MCUTest, HandleSVC_CreateTaskStatic_Test) {
+  void* arg = reinterpret_cast<void*>(0xF1F2F3F4);
+  uint8_t stack[MINIMUM_TASK_STACK_SIZE];
+  uint8_t tcb[64];
+  Popcorn::static_task_params params = {
+    Priority::Level_5, "FuncName", tcb, stack, sizeof(stack)
+  };
+  auto frame = SyscallFrame(SyscallIdx::CreateTaskStatic,
+                            (uint32_t)testfunc, 0xF1F2F3F4,
+                            (uint32_t)&params);
+
+  EXPECT_CALL(*kernel, CreateTaskStatic(testfunc, arg, Ref(params)))
+      .Times(1).RetiresOnSaturation();
+  HandleSVC(&frame);
+}
 
-  callStack.data[1] = (uint32_t)name;
-  callStack.data[2] = (uint32_t)stack_size;
-  EXPECT_CALL(*kernel, CreateTask(testfunc, arg, prio, StrEq(name), stack_size))
+TEST_F(MCUTest, HandleSVC_CreatePeriodicTask_Test) {
+  void* arg = reinterpret_cast<void*>(0xF1F2F3F4);
+  Popcorn::periodic_task_params params = {
+    Priority::Level_5, "FuncName", 123, 10, 5
+  };
+  auto frame = SyscallFrame(SyscallIdx::CreatePeriodicTask,
+                            (uint32_t)testfunc, 0xF1F2F3F4,
+                            (uint32_t)&params);
+
+  EXPECT_CALL(*kernel, CreatePeriodicTask(testfunc, arg, Ref(params)))
       .Times(1).RetiresOnSaturation();
-  HandleSVC(&callStack.frame);
+  HandleSVC(&frame);
 }
 
-TEST_F(MCUTest, HandleSVC_Sleep_Test) {
-  SVC_OP Sleep_SVC(static_cast<uint8_t>(SyscallIdx::Sleep));
-  struct CallStack callStack;
-  callStack.frame.pc = (uint32_t)(&Sleep_SVC) + sizeof(uint16_t);
-  callStack.frame.xpsr = 0;
+TEST_F(MCUTest, HandleSVC_WaitForNextPeriod_Test) {
+  auto frame = SyscallFrame(SyscallIdx::WaitForNextPeriod);
+
+  EXPECT_CALL(*kernel, WaitForNextPeriod()).Times(1).RetiresOnSaturation();
+  HandleSVC(&frame);
+}
 
+TEST_F(MCUTest, HandleSVC_Sleep_Test) {
   constexpr uint32_t sleep_time_ms = 1234;
-  callStack.frame.r1 = sleep_time_ms;
+  auto frame = SyscallFrame(SyscallIdx::Sleep, sleep_time_ms);
 
   EXPECT_CALL(*kernel, Sleep(sleep_time_ms)).Times(1).RetiresOnSaturation();
-  HandleSVC(&callStack.frame);
+  HandleSVC(&frame);
 }
 
 TEST_F(MCUTest, HandleSVC_DestroyTask_Test) {
-  SVC_OP SVC(static_cast<uint8_t>(SyscallIdx::DestroyTask));
-  struct CallStack callStack;
-  callStack.frame.pc = (uint32_t)(&SVC) + sizeof(uint16_t);
-  callStack.frame.xpsr = 0;
+  auto frame = SyscallFrame(SyscallIdx::DestroyTask);
 
   EXPECT_CALL(*kernel, DestroyTask()).Times(1).RetiresOnSaturation();
-  HandleSVC(&callStack.frame);
+  HandleSVC(&frame);
 }
 
 TEST_F(MCUTest, HandleSVC_Yield_Test) {
-  SVC_OP SVC(static_cast<uint8_t>(SyscallIdx::Yield));
-  struct CallStack callStack;
-  callStack.frame.pc = (uint32_t)(&SVC) + sizeof(uint16_t);
-  callStack.frame.xpsr = 0;
+  auto frame = SyscallFrame(SyscallIdx::Yield);
 
   EXPECT_CALL(*kernel, Yield()).Times(1).RetiresOnSaturation();
-  HandleSVC(&callStack.frame);
+  HandleSVC(&frame);
 }
 
 TEST_F(MCUTest, HandleSVC_Wait_Test) {
-  SVC_OP SVC(static_cast<uint8_t>(SyscallIdx::Wait));
-  struct CallStack callStack;
-  callStack.frame.pc = (uint32_t)(&SVC) + sizeof(uint16_t);
-  callStack.frame.xpsr = 0;
-
   Lockable lockable;
-  callStack.frame.r1 = (uint32_t)&lockable;
+  auto frame = SyscallFrame(SyscallIdx::Wait, (uint32_t)&lockable);
 
   EXPECT_CALL(*kernel, Wait(Ref(lockable))).Times(1).RetiresOnSaturation();
-  HandleSVC(&callStack.frame);
+  HandleSVC(&frame);
 }
 
 TEST_F(MCUTest, HandleSVC_RegisterError_Test) {
-  SVC_OP SVC(static_cast<uint8_t>(SyscallIdx::RegisterError));
-  struct CallStack callStack;
-  callStack.frame.pc = (uint32_t)(&SVC) + sizeof(uint16_t);
-  callStack.frame.xpsr = 0;
+  auto frame = SyscallFrame(SyscallIdx::RegisterError);
 
   EXPECT_CALL(*kernel, RegisterError())
     .Times(1).RetiresOnSaturation();
-  HandleSVC(&callStack.frame);
+  HandleSVC(&frame);
 }
 
 TEST_F(MCUTest, HandleSVC_Unknown_Test) {
-  SVC_OP SVC(0xFF);
-  struct CallStack callStack;
-  callStack.frame.pc = (uint32_t)(&SVC) + sizeof(uint16_t);
-  callStack.frame.xpsr = 0;
+  auto frame = SyscallFrame(static_cast<SyscallIdx>(0xFF));
 
   EXPECT_CALL(*kernel, RegisterError())
     .Times(1).RetiresOnSaturation();
-  HandleSVC(&callStack.frame);
+  HandleSVC(&frame);
 }
 
 TEST_F(MCUTest, HandleSVC_Lock_Test) {
-  SVC_OP SVC(static_cast<uint8_t>(SyscallIdx::Lock));
-  struct CallStack callStack;
-  callStack.frame.pc = (uint32_t)(&SVC) + sizeof(uint16_t);
-  callStack.frame.xpsr = 0;
-
   Lockable lockable;
-  callStack.frame.r1 = (uint32_t)&lockable;
-  callStack.frame.r2 = (uint32_t)true;
+  auto frame = SyscallFrame(SyscallIdx::Lock, (uint32_t)&lockable, true);
 
   EXPECT_CALL(*kernel, Lock(Ref(lockable), true)).Times(1).RetiresOnSaturation();
-  HandleSVC(&callStack.frame);
+  HandleSVC(&frame);
 
-  callStack.frame.r1 = (uint32_t)&lockable;
-  callStack.frame.r2 = (uint32_t)false;
+  frame.r1 = (uint32_t)false;
 
   EXPECT_CALL(*kernel, Lock(Ref(lockable), false)).Times(1).RetiresOnSaturation();
-  HandleSVC(&callStack.frame);
+  HandleSVC(&frame);
+}
+
+TEST_F(MCUTest, HandleSVC_SwitchesOnExit_Test) {
+  auto frame = SyscallFrame(SyscallIdx::Yield);
+
+  // Nothing to switch to
+  scb.ICSR = 0U;
+  EXPECT_CALL(*kernel, Yield()).Times(1).RetiresOnSaturation();
+  EXPECT_FALSE(HandleSVC_Static(&frame, true));
+
+  // The pending switch is taken over by the SVC handler
+  EXPECT_CALL(*kernel, Yield())
+    .WillOnce([this]() { scb.ICSR = Hw::SCB_ICSR_PENDSVSET; });
+  EXPECT_TRUE(HandleSVC_Static(&frame, true));
+  EXPECT_EQ(scb.ICSR, Hw::SCB_ICSR_PENDSVCLR);
+
+  // Calls on the main stack leave it to PendSV
+  EXPECT_CALL(*kernel, Yield())
+    .WillOnce([this]() { scb.ICSR = Hw::SCB_ICSR_PENDSVSET; });
+  EXPECT_FALSE(HandleSVC_Static(&frame, false));
+  EXPECT_EQ(scb.ICSR, Hw::SCB_ICSR_PENDSVSET);
 }
 
 TEST_F(MCUTest, EnableDisableInterrupts) {
@@ -273,6 +289,68 @@ TEST_F(MCUTest, Initialize) {
   EXPECT_TRUE(scb.CCR & Hw::SCB_CCR_STKALIGN);
 }
 
+TEST_F(MCUTest, SuppressTicks) {
+  systick.CTRL = 7U;
+  systick.LOAD = 71999U;
+  systick.VAL = 1000U;
+  scb.ICSR = 0U;
+
+  EXPECT_EQ(mcu->SuppressTicks(10), 10U);
+  EXPECT_EQ(systick.LOAD, 1000U + 9U * 72000U - 1U);
+  EXPECT_EQ(systick.VAL, 0U);
+  EXPECT_EQ(systick.CTRL, 7U);
+
+  // Woken up early, after 3 ticks
+  systick.CTRL = 7U;
+  systick.VAL = 6U * 72000U + 10U;
+  EXPECT_EQ(mcu->RestoreTicks(), 3U);
+  EXPECT_EQ(systick.LOAD, 71999U);
+  EXPECT_EQ(systick.VAL, 0U);
+  EXPECT_EQ(systick.CTRL, 7U);
+
+  // Not suppressed anymore
+  EXPECT_EQ(mcu->RestoreTicks(), 0U);
+}
+
+TEST_F(MCUTest, SuppressTicksWholePeriod) {
+  systick.VAL = 0U;
+  scb.ICSR = 0U;
+
+  // Clamped to the 24 bit range of the timer
+  EXPECT_EQ(mcu->SuppressTicks(1000), 233U);
+  EXPECT_LE(systick.LOAD, Hw::SysTick_Load_Max);
+
+  systick.CTRL = 7U | Hw::SysTick_Ctrl_CountFlag;
+  EXPECT_EQ(mcu->RestoreTicks(), 233U);
+  EXPECT_EQ(systick.LOAD, 71999U);
+}
+
+TEST_F(MCUTest, SuppressTicksWithPendingTick) {
+  systick.CTRL = 7U;
+  systick.LOAD = 71999U;
+  scb.ICSR = Hw::SCB_ICSR_PENDSTSET;
+
+  EXPECT_EQ(mcu->SuppressTicks(10), 0U);
+  EXPECT_EQ(mcu->SuppressTicks(1), 0U);
+  EXPECT_EQ(systick.LOAD, 71999U);
+  EXPECT_EQ(mcu->RestoreTicks(), 0U);
+}
+
+TEST_F(MCUTest, SetStackGuard) {
+  mpu.RBAR = 0U;
+  mpu.RASR = 0U;
+
+  mcu->SetStackGuard(0x20001040U);
+  // Region 7, selected through the valid bit
+  EXPECT_EQ(mpu.RBAR, 0x20001040U | Hw::MPU_Rbar_Valid | 7U);
+
+  // Enabled no-access region, at least 32 bytes long
+  EXPECT_TRUE(mpu.RASR & Hw::MPU_Rasr_Enable);
+  EXPECT_TRUE(mpu.RASR & Hw::MPU_Rasr_XN);
+  EXPECT_EQ(mpu.RASR & (7U << 24), Hw::MPU_Rasr_AP_NoAccess);
+  EXPECT_GE((mpu.RASR >> Hw::MPU_Rasr_Size_Pos) & 0x1FU, 4U);
+}
+
 TEST_F(MCUTest, InitializeTask) {
   constexpr uint32_t kStackSize = 1024;
   uint8_t stack[kStackSize];
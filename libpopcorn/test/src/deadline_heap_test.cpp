@@ -0,0 +1,108 @@
+/*
+ * This file is part of Popcorn
+ * Copyright (c) 2020 Javier Alvarez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+#include <cstddef>
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include "popcorn/core/deadline_heap.h"
+
+struct HeapTask {
+  std::uint64_t deadline;
+  int priority;
+  std::size_t heap_index;
+};
+
+class DeadlineHeapTest: public ::testing::Test {
+ protected:
+  Popcorn::DeadlineHeap<HeapTask, 8> heap;
+};
+
+TEST_F(DeadlineHeapTest, EmptyHeap) {
+  EXPECT_EQ(heap.Top(), nullptr);
+  EXPECT_EQ(heap.Size(), 0U);
+}
+
+TEST_F(DeadlineHeapTest, TopHasEarliestDeadline) {
+  HeapTask tasks[] = {
+    { 50, 0, 0 }, { 20, 0, 0 }, { 70, 0, 0 }, { 10, 0, 0 }, { 30, 0, 0 }
+  };
+  for (auto& task : tasks) {
+    heap.Push(&task);
+  }
+  EXPECT_EQ(heap.Size(), 5U);
+
+  for (std::uint64_t deadline : { 10, 20, 30, 50, 70 }) {
+    HeapTask* top = heap.Top();
+    ASSERT_NE(top, nullptr);
+    EXPECT_EQ(top->deadline, deadline);
+    heap.Remove(top);
+  }
+  EXPECT_EQ(heap.Top(), nullptr);
+}
+
+TEST_F(DeadlineHeapTest, EqualDeadlinesOrderedByPriority) {
+  HeapTask low = { 10, 1, 0 };
+  HeapTask high = { 10, 5, 0 };
+  HeapTask later = { 11, 9, 0 };
+  heap.Push(&low);
+  heap.Push(&later);
+  heap.Push(&high);
+
+  EXPECT_EQ(heap.Top(), &high);
+  heap.Remove(&high);
+  EXPECT_EQ(heap.Top(), &low);
+  heap.Remove(&low);
+  EXPECT_EQ(heap.Top(), &later);
+}
+
+TEST_F(DeadlineHeapTest, RemoveArbitraryTask) {
+  HeapTask tasks[] = {
+    { 1, 0, 0 }, { 2, 0, 0 }, { 3, 0, 0 }, { 4, 0, 0 },
+    { 5, 0, 0 }, { 6, 0, 0 }, { 7, 0, 0 }
+  };
+  for (auto& task : tasks) {
+    heap.Push(&task);
+  }
+
+  // Remove tasks from the middle and the leaves of the heap
+  heap.Remove(&tasks[1]);
+  heap.Remove(&tasks[6]);
+  heap.Remove(&tasks[3]);
+  EXPECT_EQ(heap.Size(), 4U);
+
+  for (std::uint64_t deadline : { 1, 3, 5, 6 }) {
+    HeapTask* top = heap.Top();
+    ASSERT_NE(top, nullptr);
+    EXPECT_EQ(top->deadline, deadline);
+    heap.Remove(top);
+  }
+}
+
+TEST_F(DeadlineHeapTest, ReinsertedTaskMovesUp) {
+  HeapTask a = { 10, 0, 0 };
+  HeapTask b = { 20, 0, 0 };
+  heap.Push(&a);
+  heap.Push(&b);
+
+  heap.Remove(&b);
+  b.deadline = 5;
+  heap.Push(&b);
+  EXPECT_EQ(heap.Top(), &b);
+}
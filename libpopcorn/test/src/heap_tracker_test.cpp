@@ -0,0 +1,147 @@
+/*
+ * This file is part of Popcorn
+ * Copyright (c) 2020 Javier Alvarez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include "popcorn/utils/heap_tracker.h"
+
+using Popcorn::HeapTracker;
+
+namespace {
+struct leak {
+  const void* owner;
+  const void* ptr;
+  std::size_t size;
+  const void* site;
+};
+std::vector<leak> g_leaks;
+}  // namespace
+
+void App_HeapLeak_Hook(const void* owner, const void* ptr, std::size_t size,
+                       const void* site) {
+  g_leaks.push_back({ owner, ptr, size, site });
+}
+
+class HeapTrackerTest: public ::testing::Test {
+ protected:
+  void SetUp() override {
+    g_leaks.clear();
+  }
+
+  void* Tag(std::size_t index, std::size_t size, const void* owner) {
+    return tracker.Tag(&blocks[index], HeapTracker::kTagSize, size, owner,
+                       &sites[index]);
+  }
+
+  bool IsTracked(const void* ptr) {
+    for (const auto* tag : tracker.m_tags) {
+      if (tag == HeapTracker::TagOf(ptr)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  struct block {
+    alignas(8) std::uint8_t bytes[HeapTracker::kTagSize + 64];
+  };
+
+  HeapTracker tracker;
+  block blocks[4];
+  int sites[4];
+  int owners[2];
+};
+
+TEST_F(HeapTrackerTest, CountsBytesInUseAndHighWatermark) {
+  tracker.RecordAllocation(64);
+  tracker.RecordAllocation(128);
+  EXPECT_EQ(tracker.BytesInUse(), 192U);
+  EXPECT_EQ(tracker.Allocations(), 2U);
+
+  tracker.RecordFree(128);
+  tracker.RecordAllocation(32);
+  EXPECT_EQ(tracker.BytesInUse(), 96U);
+  EXPECT_EQ(tracker.HighWatermark(), 192U);
+  EXPECT_EQ(tracker.Allocations(), 2U);
+
+  tracker.RecordFree(64);
+  tracker.RecordFree(32);
+  EXPECT_EQ(tracker.BytesInUse(), 0U);
+  EXPECT_EQ(tracker.HighWatermark(), 192U);
+}
+
+TEST_F(HeapTrackerTest, TagsPrecedeAllocations) {
+  void* ptr = Tag(0, 10, &owners[0]);
+  EXPECT_EQ(ptr, &blocks[0].bytes[HeapTracker::kTagSize]);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(ptr) % 8, 0U);
+  EXPECT_TRUE(IsTracked(ptr));
+
+  auto* tag = HeapTracker::TagOf(ptr);
+  EXPECT_EQ(tag->owner, &owners[0]);
+  EXPECT_EQ(tag->site, &sites[0]);
+  EXPECT_EQ(tag->size, 10U);
+
+  EXPECT_EQ(tracker.Untag(ptr), &blocks[0]);
+  EXPECT_FALSE(IsTracked(ptr));
+}
+
+TEST_F(HeapTrackerTest, TagsAlignedAllocations) {
+  // Aligned allocations may be placed further into the block
+  void* ptr = tracker.Tag(&blocks[0], 64, 8, &owners[0], &sites[0]);
+  EXPECT_EQ(ptr, &blocks[0].bytes[64]);
+  EXPECT_EQ(tracker.Untag(ptr), &blocks[0]);
+}
+
+TEST_F(HeapTrackerTest, AccountsUsagePerOwner) {
+  void* first = Tag(0, 10, &owners[0]);
+  Tag(1, 20, &owners[1]);
+  Tag(2, 30, &owners[0]);
+  Tag(3, 40, nullptr);
+
+  EXPECT_EQ(tracker.UsageOf(&owners[0]), 40U);
+  EXPECT_EQ(tracker.UsageOf(&owners[1]), 20U);
+  EXPECT_EQ(tracker.UsageOf(nullptr), 40U);
+
+  tracker.Untag(first);
+  EXPECT_EQ(tracker.UsageOf(&owners[0]), 30U);
+}
+
+TEST_F(HeapTrackerTest, ReportsLeaksOfOwner) {
+  void* first = Tag(0, 10, &owners[0]);
+  Tag(1, 20, &owners[1]);
+  void* third = Tag(2, 30, &owners[0]);
+
+  EXPECT_EQ(tracker.ReportLeaks(&owners[0]), 2U);
+  ASSERT_EQ(g_leaks.size(), 2U);
+  EXPECT_EQ(g_leaks[0].owner, &owners[0]);
+  EXPECT_EQ(g_leaks[0].ptr, first);
+  EXPECT_EQ(g_leaks[0].size, 10U);
+  EXPECT_EQ(g_leaks[0].site, &sites[0]);
+  EXPECT_EQ(g_leaks[1].ptr, third);
+  EXPECT_EQ(g_leaks[1].site, &sites[2]);
+
+  g_leaks.clear();
+  tracker.Untag(first);
+  tracker.Untag(third);
+  EXPECT_EQ(tracker.ReportLeaks(&owners[0]), 0U);
+  EXPECT_TRUE(g_leaks.empty());
+}
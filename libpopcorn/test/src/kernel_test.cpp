@@ -22,8 +22,11 @@
 
 #include "test/mock_mcu.h"
 #include "test/mock_mem_management.h"
+#include "popcorn/API/static_task.h"
+#include "popcorn/API/system.h"
 #include "popcorn/core/kernel.h"
 #include "popcorn/core/syscall_idx.h"
+#include "popcorn/primitives/ceiling_mutex.h"
 
 using ::testing::StrictMock;
 using ::testing::Return;
@@ -44,6 +47,10 @@ using Popcorn::Priority;
 using Popcorn::task_state;
 using Popcorn::Lockable;
 using Popcorn::SyscallIdx;
+using Popcorn::CeilingMutex;
+using Popcorn::LinkedList;
+using Popcorn::StaticTask;
+using Popcorn::System;
 
 using Hw::task_stack_frame;
 
@@ -61,6 +68,10 @@ class KernelTest: public ::testing::Test {
   void SetUp() override {
     g_MockMemManagement = &memManagement;
     g_svc = &svc;
+    // The kernel behind the Syscall API is built on first use and
+    // would take over g_kernel, which locks rely on
+    Popcorn::Syscall::Instance();
+    Hw::g_mcu = &mcu;
     EXPECT_CALL(mcu, RegisterSyscallImpl(_));
     kernel = make_unique<Kernel>(&mcu);
 
@@ -68,10 +79,10 @@ class KernelTest: public ::testing::Test {
     memset(task1Stack, 0xA5, sizeof(task1Stack));
     memset(task2Stack, 0xA5, sizeof(task2Stack));
     memset(task3Stack, 0xA5, sizeof(task3Stack));
-    memset(&idleTCB, 0xA5, sizeof(idleTCB));
-    memset(&task1TCB, 0xA5, sizeof(task1TCB));
-    memset(&task2TCB, 0xA5, sizeof(task2TCB));
-    memset(&task3TCB, 0xA5, sizeof(task3TCB));
+    memset(static_cast<void*>(&idleTCB), 0xA5, sizeof(idleTCB));
+    memset(static_cast<void*>(&task1TCB), 0xA5, sizeof(task1TCB));
+    memset(static_cast<void*>(&task2TCB), 0xA5, sizeof(task2TCB));
+    memset(static_cast<void*>(&task3TCB), 0xA5, sizeof(task3TCB));
   }
 
   void TearDown() override {
@@ -80,8 +91,16 @@ class KernelTest: public ::testing::Test {
   }
 
  protected:
-  LinkedList_t* GetReadyTaskList() {
-    return kernel->m_ready_list;
+  LinkedList<task_control_block>& GetReadyTaskList(Priority priority) {
+    return kernel->m_scheduler.m_ready_lists[static_cast<std::size_t>(priority)];
+  }
+
+  uint32_t GetReadyBitmap() {
+    return kernel->m_scheduler.m_ready_bitmap;
+  }
+
+  LinkedList<task_control_block>& GetSleepingTaskList() {
+    return kernel->m_sleeping_list;
   }
 
   task_control_block* GetCurrentTask() {
@@ -108,6 +127,14 @@ class KernelTest: public ::testing::Test {
     kernel->m_current_task = tcb;
   }
 
+  LinkedList<task_control_block>& GetWaiterList(Lockable& lockable) {
+    return lockable.m_waiters;
+  }
+
+  void EnableTicklessIdle() {
+    kernel->m_tickless_idle = true;
+  }
+
   static void TaskFunction(void* arg) { }
 
   void CreateTask(Priority priority,
@@ -124,6 +151,21 @@ class KernelTest: public ::testing::Test {
     kernel->CreateTask(TaskFunction, nullptr, priority, "TaskName", kStackSize);
   }
 
+  void CreatePeriodicTask(Popcorn::periodic_task_params params,
+                          task_control_block* tcb,
+                          uint8_t* stack) {
+    EXPECT_CALL(memManagement, Malloc(sizeof(task_control_block)))
+        .Times(1).WillOnce(Return(tcb)).RetiresOnSaturation();
+    EXPECT_CALL(memManagement, Malloc(kStackSize))
+        .Times(1).WillOnce(Return(stack)).RetiresOnSaturation();
+    EXPECT_CALL(mcu, InitializeTask(stack + kStackSize,
+                                    TaskFunction,
+                                    nullptr))
+                                    .WillOnce(Return(stack + kStackSize - 10));
+    params.stack_size = kStackSize;
+    kernel->CreatePeriodicTask(TaskFunction, nullptr, params);
+  }
+
   void StartOS() {
     EXPECT_CALL(memManagement, Malloc(sizeof(task_control_block)))
         .Times(1).WillOnce(Return(&idleTCB)).RetiresOnSaturation();
@@ -181,7 +223,7 @@ TEST_F(KernelTest, CreateTaskInitializesTCB_Test) {
                      "NewTask",
                      kStackSize);
 
-  ASSERT_EQ(CONTAINER_OF(GetReadyTaskList(), task_control_block, list),
+  ASSERT_EQ(GetReadyTaskList(Priority::Level_7).Front(),
     &task1TCB);
   ASSERT_STREQ(task1TCB.name, "NewTask");
   ASSERT_EQ(task1TCB.state, task_state::READY);
@@ -189,11 +231,38 @@ TEST_F(KernelTest, CreateTaskInitializesTCB_Test) {
   ASSERT_EQ(task1TCB.arg, reinterpret_cast<uintptr_t>(&arg));
   ASSERT_EQ(task1TCB.func, &TaskFunction);
   ASSERT_EQ(task1TCB.stack_base, (uintptr_t)task1Stack);
-  ASSERT_EQ(task1TCB.run_last_timestamp, 0ULL);
+  ASSERT_EQ(task1TCB.stack_size, kStackSize);
+  ASSERT_EQ(task1TCB.time_slice,
+            TIME_SLICE_TICKS[static_cast<std::size_t>(Priority::Level_7)]);
   ASSERT_EQ(reinterpret_cast<uint8_t*>(task1TCB.stack_ptr),
     task1Stack + kStackSize - 10);
 }
 
+TEST_F(KernelTest, StackHighWatermark_Test) {
+  EXPECT_CALL(memManagement, Malloc(kStackSize))
+    .Times(1).WillOnce(Return(task1Stack)).RetiresOnSaturation();
+  EXPECT_CALL(memManagement, Malloc(sizeof(task_control_block)))
+    .Times(1).WillOnce(Return(&task1TCB)).RetiresOnSaturation();
+  EXPECT_CALL(mcu, InitializeTask(task1Stack + kStackSize,
+                                  TaskFunction,
+                                  nullptr))
+                                  .WillOnce(Return(task1Stack + kStackSize));
+  kernel->CreateTask(TaskFunction, nullptr, Priority::Level_7,
+                     "NewTask", kStackSize);
+
+  // The stack is filled on creation
+  EXPECT_EQ(kernel->GetStackHighWatermark(&task1TCB), 0U);
+
+  // The task uses the top of its stack
+  memset(task1Stack + kStackSize - 100, 0, 100);
+  EXPECT_EQ(kernel->GetStackHighWatermark(&task1TCB), 100U);
+  memset(task1Stack + kStackSize - 40, 0, 40);
+  EXPECT_EQ(kernel->GetStackHighWatermark(&task1TCB), 100U);
+
+  // The main stack is only measured when ISR_STACK_SIZE is set
+  EXPECT_EQ(kernel->GetIsrStackHighWatermark(), 0U);
+}
+
 TEST_F(KernelTest, StartOS_Test) {
   EXPECT_CALL(mcu, Initialize()).Times(1);
   EXPECT_CALL(mcu, TriggerPendSV()).Times(1);
@@ -208,7 +277,7 @@ TEST_F(KernelTest, StartOS_Test) {
     .WillOnce(Return(idleStack + MINIMUM_TASK_STACK_SIZE - 10));
   kernel->StartOS();
 
-  ASSERT_EQ(CONTAINER_OF(GetReadyTaskList(), task_control_block, list),
+  ASSERT_EQ(GetReadyTaskList(Priority::IDLE).Front(),
     &idleTCB);
   ASSERT_STREQ(idleTCB.name, "Idle");
   ASSERT_EQ(idleTCB.state, task_state::READY);
@@ -250,25 +319,15 @@ TEST_F(KernelTest, CreateTask_Test) {
   kernel->CreateTask(TaskFunction, &args[1], Priority::Level_7,
                        "TestTask2", kStackSize);
 
-  int i = 0;
-  task_control_block* tcb = nullptr;
-  LinkedList_WalkEntry(GetReadyTaskList(), tcb, list) {
-    task_control_block* expected_tcb = nullptr;
-    switch (i) {
-      case 0:
-        expected_tcb = &task1TCB;
-        break;
-      case 1:
-        expected_tcb = &task2TCB;
-        break;
-      default:
-        FAIL();
-        break;
-    }
+  EXPECT_EQ(GetReadyTaskList(Priority::Level_3).Front(), &task1TCB);
+  EXPECT_EQ(GetReadyTaskList(Priority::Level_3).Next(&task1TCB), nullptr);
+  EXPECT_EQ(GetReadyTaskList(Priority::Level_7).Front(), &task2TCB);
+  EXPECT_EQ(GetReadyTaskList(Priority::Level_7).Next(&task2TCB), nullptr);
 
-    ASSERT_EQ(tcb, expected_tcb);
-    i++;
-  }
+  constexpr uint32_t expected_bitmap =
+    (1U << static_cast<uint32_t>(Priority::Level_3)) |
+    (1U << static_cast<uint32_t>(Priority::Level_7));
+  EXPECT_EQ(GetReadyBitmap(), expected_bitmap);
 }
 
 TEST_F(KernelTest, CreateTask_MallocFail_Test) {
@@ -278,7 +337,66 @@ TEST_F(KernelTest, CreateTask_MallocFail_Test) {
   kernel->CreateTask(TaskFunction, &arg, Priority::Level_3,
                      "Nulltask", MINIMUM_TASK_STACK_SIZE);
 
-  EXPECT_EQ(GetReadyTaskList(), nullptr);
+  EXPECT_TRUE(GetReadyTaskList(Priority::Level_3).Empty());
+  EXPECT_EQ(GetReadyBitmap(), 0U);
+}
+
+TEST_F(KernelTest, CreateTaskStaticDoesNotUseHeap_Test) {
+  // Any call to the memory management mock would fail the test
+  static StaticTask<kStackSize> task;
+  auto params = task.Params(Priority::Level_3, "Static");
+  auto* tcb = reinterpret_cast<task_control_block*>(params.tcb);
+  EXPECT_CALL(mcu, InitializeTask(params.stack + kStackSize,
+                                  TaskFunction,
+                                  nullptr))
+                                  .WillOnce(Return(params.stack));
+  kernel->CreateTaskStatic(TaskFunction, nullptr, params);
+
+  EXPECT_EQ(GetReadyTaskList(Priority::Level_3).Front(), tcb);
+  EXPECT_STREQ(tcb->name, "Static");
+  EXPECT_EQ(tcb->state, task_state::READY);
+  EXPECT_EQ(tcb->stack_base, reinterpret_cast<uintptr_t>(params.stack));
+  EXPECT_EQ(tcb->stack_ptr, reinterpret_cast<uintptr_t>(params.stack));
+
+  // Destroying the task does not free its storage
+  SetCurrentTask(tcb);
+  EXPECT_CALL(mcu, TriggerPendSV()).Times(1);
+  kernel->DestroyTask();
+  EXPECT_TRUE(GetReadyTaskList(Priority::Level_3).Empty());
+}
+
+namespace {
+void SystemTask(void*) { }
+uint32_t g_system_task_arg;
+
+constexpr Popcorn::task_description kSystemTasks[] = {
+  { SystemTask, &g_system_task_arg, Priority::Level_2, "First", 1000 },
+  { SystemTask, nullptr, Priority::Level_4, "Second", 100 },
+};
+}  // namespace
+
+TEST_F(KernelTest, SystemCreatesTasksFromTable_Test) {
+  // Any call to the memory management mock would fail the test
+  static System<kSystemTasks> system;
+  EXPECT_CALL(mcu, InitializeTask(_, SystemTask, &g_system_task_arg))
+    .WillOnce(Return(task1Stack));
+  EXPECT_CALL(mcu, InitializeTask(_, SystemTask, nullptr))
+    .WillOnce(Return(task2Stack));
+  system.CreateTasks(kernel.get());
+
+  auto* first = GetReadyTaskList(Priority::Level_2).Front();
+  auto* second = GetReadyTaskList(Priority::Level_4).Front();
+  ASSERT_NE(first, nullptr);
+  ASSERT_NE(second, nullptr);
+  EXPECT_STREQ(first->name, "First");
+  EXPECT_STREQ(second->name, "Second");
+
+  // Stacks are laid out back to back, rounded up to 8 bytes
+  // and to the minimum stack size
+  EXPECT_EQ(first->stack_base % 8, 0U);
+  EXPECT_EQ(second->stack_base - first->stack_base, 1000U);
+  EXPECT_GE(sizeof(system), sizeof(task_control_block) * 2 +
+                            1000U + MINIMUM_TASK_STACK_SIZE);
 }
 
 TEST_F(KernelTest, DestroyTask_Test) {
@@ -306,7 +424,7 @@ TEST_F(KernelTest, DestroyTask_Test) {
                      "TestTask2", kStackSize);
 
   // Set first task as current task
-  SetCurrentTask(CONTAINER_OF(GetReadyTaskList(), task_control_block, list));
+  SetCurrentTask(GetReadyTaskList(Priority::Level_3).Front());
 
   EXPECT_CALL(memManagement, Free(task1Stack))
     .Times(1).RetiresOnSaturation();
@@ -315,22 +433,10 @@ TEST_F(KernelTest, DestroyTask_Test) {
   EXPECT_CALL(mcu, TriggerPendSV()).Times(1);
   kernel->DestroyTask();
 
-  int i = 0;
-  task_control_block* tcb = nullptr;
-  LinkedList_WalkEntry(GetReadyTaskList(), tcb, list) {
-    task_control_block *expected_tcb = nullptr;
-    switch (i) {
-    case 0:
-      expected_tcb = &task2TCB;
-      break;
-
-    default:
-      FAIL();
-      break;
-    }
-    EXPECT_EQ(tcb, expected_tcb);
-    i++;
-  }
+  EXPECT_TRUE(GetReadyTaskList(Priority::Level_3).Empty());
+  EXPECT_EQ(GetReadyTaskList(Priority::Level_7).Front(), &task2TCB);
+  EXPECT_EQ(GetReadyTaskList(Priority::Level_7).Next(&task2TCB), nullptr);
+  EXPECT_EQ(GetReadyBitmap(), 1U << static_cast<uint32_t>(Priority::Level_7));
 }
 
 TEST_F(KernelTest, Ticks_Test) {
@@ -409,12 +515,16 @@ TEST_F(KernelTest, Sleep_Test) {
 
   TriggerScheduler();
 
-  for (uint32_t i = 0; i < SLEEP_TICKS; i++) {
+  // The idle task keeps running, no context switch is needed
+  for (uint32_t i = 0; i < SLEEP_TICKS - 1; i++) {
     EXPECT_EQ(GetCurrentTask(), &idleTCB);
-    EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
     HandleTick();
-    TriggerScheduler();
   }
+  EXPECT_EQ(kernel->GetSkippedContextSwitches(), SLEEP_TICKS - 1);
+
+  EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
+  HandleTick();
+  TriggerScheduler();
 
   EXPECT_EQ(GetCurrentTask(), &task1TCB);
 }
@@ -426,25 +536,39 @@ class FakeBlock: public Lockable {
     m_kernel(kernel) { }
 
   void Lock() {
-    if (m_blocked) {
-      Block();
-      m_kernel->Wait(*this);
-    } else {
-      m_blocked = true;
+    if (!TryAcquire()) {
+      Wait();
+    }
+  }
+
+  // Reports the owner to the kernel before any contention
+  void LockTracked() {
+    if (TryAcquire()) {
       LockAcquired();
       m_kernel->Lock(*this, true);
+    } else {
+      Wait();
     }
   }
 
+  void Wait() {
+    Block();
+    m_kernel->Wait(*this);
+  }
+
   void Unlock() {
-    m_blocked = false;
-    LockReleased();
-    m_kernel->Lock(*this, false);
+    if (!TryRelease()) {
+      LockReleased();
+      m_kernel->Lock(*this, false);
+    }
+  }
+
+  bool IsHeld() {
+    return m_state != 0;
   }
 
  private:
   Kernel* m_kernel;
-  bool m_blocked = false;
 };
 
 }  // namespace
@@ -488,7 +612,7 @@ TEST_F(KernelTest, Wait_Test) {
                      "TestTask2", kStackSize);
 
   EXPECT_CALL(svc, SupervisorCall(SyscallIdx::Lock));
-  block.Lock();
+  block.LockTracked();
 
   TriggerScheduler();
   EXPECT_EQ(GetCurrentTask(), &task2TCB);
@@ -537,7 +661,6 @@ TEST_F(KernelTest, Priority_Test) {
   EXPECT_NE(GetCurrentTask(), nullptr);
   EXPECT_STREQ(GetCurrentTask()->name, "TestTask1");
 
-  EXPECT_CALL(svc, SupervisorCall(SyscallIdx::Lock));
   block.Lock();
 
   EXPECT_CALL(memManagement, Malloc(sizeof(task_control_block)))
@@ -614,25 +737,68 @@ TEST_F(KernelTest, EqualPriorityAppliesRoundRobin_Test) {
   kernel->CreateTask(TaskFunction, &arg, Priority::Level_1,
                      "TestTask2", kStackSize);
 
-  EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
-  HandleTick();
   TriggerScheduler();
   EXPECT_EQ(GetCurrentTask(), &task1TCB);
 
-  EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
-  HandleTick();
+  // Each task keeps the CPU for its whole time slice
+  constexpr uint32_t kSlice =
+    TIME_SLICE_TICKS[static_cast<std::size_t>(Priority::Level_1)];
+  for (auto* expected_tcb : { &task2TCB, &task1TCB, &task2TCB, &task1TCB }) {
+    for (uint32_t i = 0; i < kSlice - 1; i++) {
+      EXPECT_NE(GetCurrentTask(), expected_tcb);
+      HandleTick();
+    }
+    EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
+    HandleTick();
+    TriggerScheduler();
+    EXPECT_EQ(GetCurrentTask(), expected_tcb);
+  }
+}
+
+TEST_F(KernelTest, PreemptedTaskKeepsRemainingTimeSlice_Test) {
+  constexpr uint32_t kSlice =
+    TIME_SLICE_TICKS[static_cast<std::size_t>(Priority::Level_1)];
+
+  CreateTask(Priority::Level_1, &task1TCB, task1Stack);
+  CreateTask(Priority::Level_1, &task2TCB, task2Stack);
+  StartOS();
+
   TriggerScheduler();
-  EXPECT_EQ(GetCurrentTask(), &task2TCB);
+  EXPECT_EQ(GetCurrentTask(), &task1TCB);
 
-  EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
   HandleTick();
+  EXPECT_EQ(task1TCB.time_slice, kSlice - 1);
+
+  // A higher priority task preempts task 1 and then goes to sleep
+  CreateTask(Priority::Level_4, &task3TCB, task3Stack);
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &task3TCB);
+  EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
+  kernel->Sleep(100);
+
+  // Task 1 resumes with the rest of its slice
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &task1TCB);
+  EXPECT_EQ(task1TCB.time_slice, kSlice - 1);
+}
+
+TEST_F(KernelTest, YieldRotatesEqualPriorityTasks_Test) {
+  CreateTask(Priority::Level_1, &task1TCB, task1Stack);
+  CreateTask(Priority::Level_1, &task2TCB, task2Stack);
+  StartOS();
+
   TriggerScheduler();
   EXPECT_EQ(GetCurrentTask(), &task1TCB);
 
   EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
-  HandleTick();
+  kernel->Yield();
   TriggerScheduler();
   EXPECT_EQ(GetCurrentTask(), &task2TCB);
+
+  EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
+  kernel->Yield();
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &task1TCB);
 }
 
 TEST_F(KernelTest, PriorityInheritanceAvoidsPriorityInversion_Test) {
@@ -646,7 +812,6 @@ TEST_F(KernelTest, PriorityInheritanceAvoidsPriorityInversion_Test) {
   EXPECT_EQ(GetCurrentTask(), &task1TCB);
 
   // Task 1 takes the mutex
-  EXPECT_CALL(svc, SupervisorCall(SyscallIdx::Lock));
   mutex.Lock();
 
   CreateTask(Priority::Level_1, &task2TCB, task2Stack);
@@ -683,3 +848,430 @@ TEST_F(KernelTest, PriorityInheritanceAvoidsPriorityInversion_Test) {
   TriggerScheduler();
   EXPECT_EQ(GetCurrentTask(), &task3TCB);
 }
+
+TEST_F(KernelTest, SchedulerPicksHighestPopulatedLevel_Test) {
+  CreateTask(Priority::Level_2, &task1TCB, task1Stack);
+  CreateTask(Priority::Level_8, &task2TCB, task2Stack);
+  CreateTask(Priority::Level_5, &task3TCB, task3Stack);
+
+  StartOS();
+
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &task2TCB);
+
+  // Once the highest task leaves the ready queues the next populated
+  // level is selected, and its bit is cleared from the bitmap.
+  EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
+  kernel->Sleep(10);
+  EXPECT_EQ(GetReadyBitmap() & (1U << static_cast<uint32_t>(Priority::Level_8)),
+            0U);
+
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &task3TCB);
+
+  EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
+  kernel->Sleep(10);
+
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &task1TCB);
+
+  EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
+  kernel->Sleep(10);
+
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &idleTCB);
+  EXPECT_EQ(GetReadyBitmap(), 1U << static_cast<uint32_t>(Priority::IDLE));
+}
+
+TEST_F(KernelTest, SleepingTasksAreOrderedByWakeUpTime_Test) {
+  CreateTask(Priority::Level_3, &task1TCB, task1Stack);
+  CreateTask(Priority::Level_2, &task2TCB, task2Stack);
+  CreateTask(Priority::Level_1, &task3TCB, task3Stack);
+  StartOS();
+
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &task1TCB);
+  EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
+  kernel->Sleep(30);
+
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &task2TCB);
+  EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
+  kernel->Sleep(10);
+
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &task3TCB);
+  EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
+  kernel->Sleep(20);
+
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &idleTCB);
+
+  auto& sleeping = GetSleepingTaskList();
+  ASSERT_EQ(sleeping.Front(), &task2TCB);
+  ASSERT_EQ(sleeping.Next(&task2TCB), &task3TCB);
+  ASSERT_EQ(sleeping.Next(&task3TCB), &task1TCB);
+  ASSERT_EQ(sleeping.Next(&task1TCB), nullptr);
+
+  // Tasks wake up in order, each exactly on its tick. The scheduler
+  // does not run, so every tick after the first wake up preempts idle.
+  EXPECT_CALL(mcu, TriggerPendSV()).Times(AnyNumber());
+  for (auto [wake_tick, tcb] : { std::pair{10U, &task2TCB},
+                                 std::pair{20U, &task3TCB},
+                                 std::pair{30U, &task1TCB} }) {
+    while (GetTicks() < wake_tick - 1) {
+      HandleTick();
+      EXPECT_EQ(tcb->state, task_state::SLEEPING);
+    }
+    HandleTick();
+    EXPECT_EQ(tcb->state, task_state::READY);
+  }
+  EXPECT_TRUE(GetSleepingTaskList().Empty());
+}
+
+TEST_F(KernelTest, TicklessIdleSuppressesTicksUntilWakeUp_Test) {
+  EnableTicklessIdle();
+  CreateTask(Priority::Level_1, &task1TCB, task1Stack);
+  StartOS();
+
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &task1TCB);
+
+  EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
+  kernel->Sleep(300);
+
+  // Only the idle task is runnable. The timer can only suppress
+  // 200 ticks at once in this test.
+  EXPECT_CALL(mcu, SuppressTicks(300)).WillOnce(Return(200));
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &idleTCB);
+
+  // End of the first idle period. Idle keeps running, so the tick
+  // handler suppresses ticks again without a context switch.
+  EXPECT_CALL(mcu, RestoreTicks()).WillOnce(Return(200));
+  EXPECT_CALL(mcu, SuppressTicks(100)).WillOnce(Return(100));
+  HandleTick();
+  EXPECT_EQ(GetTicks(), 200U);
+  EXPECT_EQ(task1TCB.state, task_state::SLEEPING);
+  EXPECT_EQ(GetCurrentTask(), &idleTCB);
+
+  // End of the second idle period, the task is woken up and the
+  // tick is not suppressed anymore.
+  EXPECT_CALL(mcu, RestoreTicks()).WillOnce(Return(100));
+  EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
+  HandleTick();
+  EXPECT_EQ(GetTicks(), 300U);
+  EXPECT_EQ(task1TCB.state, task_state::READY);
+
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &task1TCB);
+
+  HandleTick();
+  EXPECT_EQ(GetTicks(), 301U);
+}
+
+TEST_F(KernelTest, TicklessIdleCatchesUpWhenScheduledEarly_Test) {
+  EnableTicklessIdle();
+  CreateTask(Priority::Level_1, &task1TCB, task1Stack);
+  StartOS();
+
+  TriggerScheduler();
+  EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
+  kernel->Sleep(50);
+
+  EXPECT_CALL(mcu, SuppressTicks(50)).WillOnce(Return(50));
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &idleTCB);
+
+  // Scheduler runs before the idle period ends
+  EXPECT_CALL(mcu, RestoreTicks()).WillOnce(Return(20));
+  EXPECT_CALL(mcu, SuppressTicks(30)).WillOnce(Return(30));
+  TriggerScheduler();
+  EXPECT_EQ(GetTicks(), 20U);
+  EXPECT_EQ(GetCurrentTask(), &idleTCB);
+}
+
+TEST_F(KernelTest, TicklessIdleNotUsedWithRunnableTasks_Test) {
+  EnableTicklessIdle();
+  CreateTask(Priority::Level_1, &task1TCB, task1Stack);
+  StartOS();
+
+  // StrictMock: no calls to SuppressTicks are expected
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &task1TCB);
+
+  HandleTick();
+  EXPECT_EQ(GetTicks(), 1U);
+}
+
+TEST_F(KernelTest, TickWithoutPreemptionSkipsContextSwitch_Test) {
+  CreateTask(Priority::Level_1, &task1TCB, task1Stack);
+  CreateTask(Priority::Level_3, &task2TCB, task2Stack);
+  StartOS();
+
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &task2TCB);
+
+  // StrictMock: task 2 is alone at its level, no PendSV is expected
+  HandleTick();
+  HandleTick();
+  EXPECT_EQ(kernel->GetSkippedContextSwitches(), 2U);
+
+  // Task 1 has lower priority, waking it up does not preempt task 2
+  EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
+  SetCurrentTask(&task1TCB);
+  kernel->Sleep(1);
+  SetCurrentTask(&task2TCB);
+
+  HandleTick();
+  EXPECT_EQ(task1TCB.state, task_state::READY);
+  EXPECT_EQ(kernel->GetSkippedContextSwitches(), 3U);
+}
+
+TEST_F(KernelTest, YieldWithoutPeersSkipsContextSwitch_Test) {
+  CreateTask(Priority::Level_1, &task1TCB, task1Stack);
+  CreateTask(Priority::Level_3, &task2TCB, task2Stack);
+  StartOS();
+
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &task2TCB);
+
+  // StrictMock: only lower priority tasks are ready, no PendSV
+  kernel->Yield();
+  EXPECT_EQ(GetCurrentTask(), &task2TCB);
+  EXPECT_EQ(kernel->GetSkippedContextSwitches(), 1U);
+}
+
+TEST_F(KernelTest, WaitersAreOrderedByPriority_Test) {
+  FakeBlock block(kernel.get());
+  task_control_block task4TCB;
+  uint8_t task4Stack[kStackSize];
+
+  CreateTask(Priority::Level_1, &task1TCB, task1Stack);
+  StartOS();
+
+  TriggerScheduler();
+  block.Lock();
+
+  // Tasks block on the resource in arbitrary priority order
+  CreateTask(Priority::Level_3, &task2TCB, task2Stack);
+  CreateTask(Priority::Level_5, &task3TCB, task3Stack);
+  CreateTask(Priority::Level_3, &task4TCB, task4Stack);
+  EXPECT_CALL(svc, SupervisorCall(SyscallIdx::Wait)).Times(3);
+  EXPECT_CALL(mcu, TriggerPendSV()).Times(3);
+  for (auto* tcb : { &task2TCB, &task3TCB, &task4TCB }) {
+    SetCurrentTask(tcb);
+    block.Lock();
+  }
+
+  auto& waiters = GetWaiterList(block);
+  ASSERT_EQ(waiters.Front(), &task3TCB);
+  ASSERT_EQ(waiters.Next(&task3TCB), &task2TCB);
+  ASSERT_EQ(waiters.Next(&task2TCB), &task4TCB);
+  ASSERT_EQ(waiters.Next(&task4TCB), nullptr);
+  EXPECT_EQ(task1TCB.priority, Priority::Level_5);
+
+  // Releasing the resource hands it over to the highest priority
+  // waiter only, which inherits the priority of the next waiters.
+  SetCurrentTask(&task1TCB);
+  EXPECT_CALL(svc, SupervisorCall(SyscallIdx::Lock));
+  EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
+  block.Unlock();
+  EXPECT_EQ(task1TCB.priority, Priority::Level_1);
+  EXPECT_EQ(task3TCB.state, task_state::READY);
+  EXPECT_EQ(task2TCB.state, task_state::BLOCKED);
+  EXPECT_EQ(task4TCB.state, task_state::BLOCKED);
+  EXPECT_EQ(GetWaiterList(block).Front(), &task2TCB);
+  EXPECT_TRUE(block.IsHeld());
+
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &task3TCB);
+
+  // Waiters of equal priority are handed the resource in FIFO order.
+  // Task 3 has the highest priority, so it keeps running.
+  EXPECT_CALL(svc, SupervisorCall(SyscallIdx::Lock));
+  block.Unlock();
+  EXPECT_EQ(task2TCB.state, task_state::READY);
+  SetCurrentTask(&task2TCB);
+  task2TCB.state = task_state::RUNNING;
+
+  EXPECT_CALL(svc, SupervisorCall(SyscallIdx::Lock));
+  EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
+  block.Unlock();
+  EXPECT_EQ(task4TCB.state, task_state::READY);
+  SetCurrentTask(&task4TCB);
+  task4TCB.state = task_state::RUNNING;
+  EXPECT_TRUE(GetWaiterList(block).Empty());
+
+  // The last owner has no waiters, it frees the resource alone
+  block.Unlock();
+  EXPECT_FALSE(block.IsHeld());
+}
+
+TEST_F(KernelTest, WaitTakesResourceReleasedBeforeBlocking_Test) {
+  FakeBlock block(kernel.get());
+
+  CreateTask(Priority::Level_1, &task1TCB, task1Stack);
+  StartOS();
+
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &task1TCB);
+
+  // The resource was freed between the failed attempt and the wait
+  // system call, the task does not block.
+  EXPECT_CALL(svc, SupervisorCall(SyscallIdx::Wait));
+  block.Wait();
+  EXPECT_EQ(task1TCB.state, task_state::RUNNING);
+  EXPECT_TRUE(block.IsHeld());
+  EXPECT_TRUE(GetWaiterList(block).Empty());
+}
+
+TEST_F(KernelTest, PriorityInheritanceFollowsBlockerChain_Test) {
+  FakeBlock blockA(kernel.get());
+  FakeBlock blockB(kernel.get());
+
+  CreateTask(Priority::Level_1, &task1TCB, task1Stack);
+  StartOS();
+
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &task1TCB);
+  blockA.Lock();
+
+  // Task 2 holds B and waits for A
+  CreateTask(Priority::Level_3, &task2TCB, task2Stack);
+  SetCurrentTask(&task2TCB);
+  blockB.Lock();
+  EXPECT_CALL(svc, SupervisorCall(SyscallIdx::Wait));
+  EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
+  blockA.Lock();
+  EXPECT_EQ(task1TCB.priority, Priority::Level_3);
+
+  // Task 3 waits for B, boosting task 2 and, through it, task 1
+  CreateTask(Priority::Level_5, &task3TCB, task3Stack);
+  SetCurrentTask(&task3TCB);
+  EXPECT_CALL(svc, SupervisorCall(SyscallIdx::Wait));
+  EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
+  blockB.Lock();
+  EXPECT_EQ(task2TCB.priority, Priority::Level_5);
+  EXPECT_EQ(task1TCB.priority, Priority::Level_5);
+
+  // Task 2 gets A and keeps the priority inherited through B
+  SetCurrentTask(&task1TCB);
+  EXPECT_CALL(svc, SupervisorCall(SyscallIdx::Lock));
+  EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
+  blockA.Unlock();
+  EXPECT_EQ(task1TCB.priority, Priority::Level_1);
+  EXPECT_EQ(task2TCB.priority, Priority::Level_5);
+
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &task2TCB);
+}
+
+TEST_F(KernelTest, ReleaseKeepsPriorityInheritedFromOtherLocks_Test) {
+  FakeBlock blockA(kernel.get());
+  FakeBlock blockB(kernel.get());
+
+  CreateTask(Priority::Level_1, &task1TCB, task1Stack);
+  StartOS();
+
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &task1TCB);
+  blockA.Lock();
+  blockB.Lock();
+
+  CreateTask(Priority::Level_3, &task2TCB, task2Stack);
+  CreateTask(Priority::Level_5, &task3TCB, task3Stack);
+  EXPECT_CALL(svc, SupervisorCall(SyscallIdx::Wait)).Times(2);
+  EXPECT_CALL(mcu, TriggerPendSV()).Times(2).RetiresOnSaturation();
+  SetCurrentTask(&task2TCB);
+  blockA.Lock();
+  SetCurrentTask(&task3TCB);
+  blockB.Lock();
+  EXPECT_EQ(task1TCB.priority, Priority::Level_5);
+
+  // Task 2 still waits for A, so task 1 keeps its priority
+  SetCurrentTask(&task1TCB);
+  EXPECT_CALL(svc, SupervisorCall(SyscallIdx::Lock));
+  EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
+  blockB.Unlock();
+  EXPECT_EQ(task1TCB.priority, Priority::Level_3);
+
+  EXPECT_CALL(svc, SupervisorCall(SyscallIdx::Lock));
+  EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
+  blockA.Unlock();
+  EXPECT_EQ(task1TCB.priority, Priority::Level_1);
+}
+
+TEST_F(KernelTest, CeilingMutexDefersPreemptionUntilUnlock_Test) {
+  CeilingMutex<Priority::Level_3> mutex;
+  static_assert(decltype(mutex)::Covers(Priority::Level_1,
+                                        Priority::Level_3));
+  static_assert(!decltype(mutex)::Covers(Priority::Level_4));
+
+  CreateTask(Priority::Level_1, &task1TCB, task1Stack);
+  StartOS();
+
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &task1TCB);
+
+  // StrictMock: neither locking nor the tick need the kernel to switch
+  mutex.Lock();
+  EXPECT_EQ(task1TCB.ceiling, Priority::Level_3);
+  CreateTask(Priority::Level_3, &task2TCB, task2Stack);
+  HandleTick();
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &task1TCB);
+
+  // Tasks above the ceiling still preempt the holder
+  CreateTask(Priority::Level_4, &task3TCB, task3Stack);
+  EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
+  HandleTick();
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &task3TCB);
+  EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
+  kernel->Sleep(100);
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &task1TCB);
+
+  // The deferred preemption happens on unlock
+  EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
+  mutex.Unlock();
+  EXPECT_EQ(task1TCB.ceiling, Priority::IDLE);
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &task2TCB);
+}
+
+TEST_F(KernelTest, PeriodicTaskIsReleasedEveryPeriod_Test) {
+  CreatePeriodicTask({ Priority::Level_2, "Periodic", 0, 10, 0 },
+                     &task1TCB, task1Stack);
+  EXPECT_EQ(task1TCB.deadline, 10U);
+  StartOS();
+
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &task1TCB);
+
+  // The job completes early, the task sleeps until the next release
+  SetTicks(3);
+  EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
+  kernel->WaitForNextPeriod();
+  EXPECT_EQ(task1TCB.state, task_state::SLEEPING);
+  EXPECT_EQ(task1TCB.deadline, 20U);
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &idleTCB);
+
+  while (GetTicks() < 9) {
+    HandleTick();
+  }
+  EXPECT_EQ(task1TCB.state, task_state::SLEEPING);
+  EXPECT_CALL(mcu, TriggerPendSV()).Times(1).RetiresOnSaturation();
+  HandleTick();
+  EXPECT_EQ(task1TCB.state, task_state::READY);
+  TriggerScheduler();
+  EXPECT_EQ(GetCurrentTask(), &task1TCB);
+
+  // The job overruns, so the next one is released right away
+  SetTicks(25);
+  kernel->WaitForNextPeriod();
+  EXPECT_EQ(task1TCB.state, task_state::RUNNING);
+  EXPECT_EQ(task1TCB.deadline, 30U);
+}
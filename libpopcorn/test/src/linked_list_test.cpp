@@ -20,155 +20,129 @@
 
 #include "popcorn/utils/linked_list.h"
 
+using Popcorn::LinkedList;
+using Popcorn::ListNode;
+
 struct ListElement {
   uint32_t a;
   uint8_t b;
-  LinkedList_t list;
+  ListNode list;
 };
 
 class LinkedListTest: public ::testing::Test {
-  void SetUp() override {
-    head = nullptr;
-  }
-
-  void TearDown() override { }
-
  protected:
-  LinkedList_t *head;
+  LinkedList<ListElement> list;
 
   ListElement element1 = {
     .a = 100,
     .b = 200,
-    .list = { .next = nullptr }
+    .list = {}
   };
   ListElement element2 = {
     .a = 100,
     .b = 200,
-    .list = { .next = nullptr }
+    .list = {}
   };
   ListElement element3 = {
     .a = 100,
     .b = 12,
-    .list = { .next = nullptr }
+    .list = {}
   };
 };
 
-TEST_F(LinkedListTest, ContainerOfTest) {
+TEST_F(LinkedListTest, FromNodeTest) {
   ListElement element;
 
-  LinkedList_t *listPtr = &element.list;
-  ListElement* elementPtr = CONTAINER_OF(listPtr, struct ListElement, list);
+  ListNode *nodePtr = &element.list;
+  ListElement* elementPtr = LinkedList<ListElement>::FromNode(nodePtr);
   ASSERT_EQ(elementPtr, &element);
 }
 
-TEST_F(LinkedListTest, AddElementTest) {
-  LinkedList_AddElement(&head, &element1.list);
-
-  ASSERT_EQ(head, &element1.list);
-  ASSERT_EQ(head->next, nullptr);
+TEST_F(LinkedListTest, EmptyListTest) {
+  ASSERT_TRUE(list.Empty());
+  ASSERT_EQ(list.Front(), nullptr);
+  ASSERT_EQ(list.Back(), nullptr);
+  ASSERT_FALSE(list.begin() != list.end());
 }
 
-TEST_F(LinkedListTest, RemoveElementTest) {
-  LinkedList_AddElement(&head, &element1.list);
+TEST_F(LinkedListTest, PushBackTest) {
+  list.PushBack(&element1);
 
-  ASSERT_EQ(head, &element1.list);
-  ASSERT_EQ(head->next, nullptr);
-
-  LinkedList_RemoveElement(&head, &element1.list);
-
-  ASSERT_EQ(head, nullptr);
+  ASSERT_FALSE(list.Empty());
+  ASSERT_EQ(list.Front(), &element1);
+  ASSERT_EQ(list.Back(), &element1);
+  ASSERT_EQ(list.Next(&element1), nullptr);
 }
 
-TEST_F(LinkedListTest, AddMultipleElementsTest) {
-  LinkedList_AddElement(&head, &element1.list);
-  LinkedList_AddElement(&head, &element2.list);
+TEST_F(LinkedListTest, RemoveTest) {
+  list.PushBack(&element1);
+  ASSERT_EQ(list.Front(), &element1);
 
-  ASSERT_EQ(head, &element1.list);
-  ASSERT_EQ(head->next, &element2.list);
-  ASSERT_EQ(head->next->next, nullptr);
+  list.Remove(&element1);
+
+  ASSERT_TRUE(list.Empty());
+  ASSERT_EQ(list.Front(), nullptr);
+  ASSERT_EQ(element1.list.prev, nullptr);
+  ASSERT_EQ(element1.list.next, nullptr);
 }
 
-TEST_F(LinkedListTest, CanRecoverListElement) {
-  LinkedList_AddElement(&head, &element1.list);
+TEST_F(LinkedListTest, PushMultipleElementsTest) {
+  list.PushBack(&element1);
+  list.PushBack(&element2);
+  list.PushFront(&element3);
 
-  ASSERT_EQ(head, &element1.list);
-  ASSERT_EQ(CONTAINER_OF(head, ListElement, list), &element1);
+  ASSERT_EQ(list.Front(), &element3);
+  ASSERT_EQ(list.Next(&element3), &element1);
+  ASSERT_EQ(list.Next(&element1), &element2);
+  ASSERT_EQ(list.Next(&element2), nullptr);
+  ASSERT_EQ(list.Back(), &element2);
 }
 
 TEST_F(LinkedListTest, CanRemoveRandomElement) {
-  LinkedList_AddElement(&head, &element1.list);
-  LinkedList_AddElement(&head, &element2.list);
-  LinkedList_AddElement(&head, &element3.list);
-
-  ASSERT_EQ(head, &element1.list);
-  ASSERT_EQ(head->next, &element2.list);
-  ASSERT_EQ(head->next->next, &element3.list);
-  ASSERT_EQ(head->next->next->next, nullptr);
-
-  LinkedList_RemoveElement(&head, &element2.list);
-  ASSERT_EQ(head, &element1.list);
-  ASSERT_EQ(head->next, &element3.list);
-  ASSERT_EQ(head->next->next, nullptr);
-
-  LinkedList_RemoveElement(&head, &element3.list);
-  ASSERT_EQ(head, &element1.list);
-  ASSERT_EQ(head->next, nullptr);
-
-  LinkedList_RemoveElement(&head, &element1.list);
-  ASSERT_EQ(head, nullptr);
-}
-
-TEST_F(LinkedListTest, AddEntryTest) {
-  LinkedList_AddEntry(head, &element1, list);
-  ASSERT_EQ(head, &element1.list);
-  ASSERT_EQ(head->next, nullptr);
-
-  LinkedList_AddEntry(head, &element2, list);
-  ASSERT_EQ(head, &element1.list);
-  ASSERT_EQ(head->next, &element2.list);
-  ASSERT_EQ(head->next->next, nullptr);
+  list.PushBack(&element1);
+  list.PushBack(&element2);
+  list.PushBack(&element3);
+
+  ASSERT_EQ(list.Front(), &element1);
+  ASSERT_EQ(list.Next(&element1), &element2);
+  ASSERT_EQ(list.Next(&element2), &element3);
+  ASSERT_EQ(list.Next(&element3), nullptr);
+
+  list.Remove(&element2);
+  ASSERT_EQ(list.Front(), &element1);
+  ASSERT_EQ(list.Next(&element1), &element3);
+  ASSERT_EQ(list.Next(&element3), nullptr);
+
+  list.Remove(&element3);
+  ASSERT_EQ(list.Front(), &element1);
+  ASSERT_EQ(list.Back(), &element1);
+
+  list.Remove(&element1);
+  ASSERT_TRUE(list.Empty());
 }
 
-TEST_F(LinkedListTest, RemoveEntryTest) {
-  LinkedList_AddEntry(head, &element1, list);
-  ASSERT_EQ(head, &element1.list);
-  ASSERT_EQ(head->next, nullptr);
-
-  LinkedList_AddEntry(head, &element2, list);
-  ASSERT_EQ(head, &element1.list);
-  ASSERT_EQ(head->next, &element2.list);
-  ASSERT_EQ(head->next->next, nullptr);
-
-  LinkedList_RemoveEntry(head, &element1, list);
-  ASSERT_EQ(head, &element2.list);
-  ASSERT_EQ(head->next, nullptr);
-
-  LinkedList_RemoveEntry(head, &element2, list);
-  ASSERT_EQ(head, nullptr);
-
-  // Try removing an element that is not in the list
-  LinkedList_AddEntry(head, &element1, list);
-  ASSERT_EQ(head, &element1.list);
-  ASSERT_EQ(head->next, nullptr);
+TEST_F(LinkedListTest, RemoveUnlinkedElementTest) {
+  list.PushBack(&element1);
 
   // The list shouldn't change
-  LinkedList_RemoveEntry(head, &element2, list);
-  ASSERT_EQ(head, &element1.list);
-  ASSERT_EQ(head->next, nullptr);
+  list.Remove(&element2);
+  ASSERT_EQ(list.Front(), &element1);
+  ASSERT_EQ(list.Back(), &element1);
+
+  // Elements can be linked again once removed
+  list.Remove(&element1);
+  list.Remove(&element1);
+  list.PushBack(&element1);
+  ASSERT_EQ(list.Front(), &element1);
 }
 
-TEST_F(LinkedListTest, WalkEntryTest) {
-  LinkedList_AddEntry(head, &element1, list);
-  LinkedList_AddEntry(head, &element2, list);
-  LinkedList_AddEntry(head, &element3, list);
-  ASSERT_EQ(head, &element1.list);
-  ASSERT_EQ(head->next, &element2.list);
-  ASSERT_EQ(head->next->next, &element3.list);
-  ASSERT_EQ(head->next->next->next, nullptr);
+TEST_F(LinkedListTest, WalkTest) {
+  list.PushBack(&element1);
+  list.PushBack(&element2);
+  list.PushBack(&element3);
 
-  ListElement* element = nullptr;
   int i = 0;
-  LinkedList_WalkEntry(head, element, list) {
+  for (ListElement* element : list) {
     switch (i) {
     case 0:
       ASSERT_EQ(element, &element1);
@@ -188,38 +162,63 @@ TEST_F(LinkedListTest, WalkEntryTest) {
   ASSERT_EQ(i, 3);
 }
 
-TEST_F(LinkedListTest, WalkEntrySafeTest) {
-  LinkedList_AddEntry(head, &element1, list);
-  LinkedList_AddEntry(head, &element2, list);
-  LinkedList_AddEntry(head, &element3, list);
-  ASSERT_EQ(head, &element1.list);
-  ASSERT_EQ(head->next, &element2.list);
-  ASSERT_EQ(head->next->next, &element3.list);
-  ASSERT_EQ(head->next->next->next, nullptr);
+TEST_F(LinkedListTest, WalkRemovingElementsTest) {
+  list.PushBack(&element1);
+  list.PushBack(&element2);
+  list.PushBack(&element3);
 
-  ListElement* element = nullptr;
   ListElement* next = nullptr;
   int i = 0;
-  LinkedList_WalkEntry_Safe(head, element, next, list) {
-    switch (i) {
-    case 0:
-      ASSERT_EQ(element, &element1);
-      ASSERT_EQ(next, &element2);
-      break;
-    case 1:
-      ASSERT_EQ(element, &element2);
-      ASSERT_EQ(next, &element3);
-      LinkedList_RemoveEntry(head, element, list);
-      break;
-    case 2:
-      ASSERT_EQ(element, &element3);
-      ASSERT_EQ(next, nullptr);
-      break;
-    default:
-      FAIL();
-      break;
+  for (ListElement* element = list.Front(); element; element = next) {
+    next = list.Next(element);
+    if (element == &element2) {
+      list.Remove(element);
     }
     i++;
   }
   ASSERT_EQ(i, 3);
+  ASSERT_EQ(list.Front(), &element1);
+  ASSERT_EQ(list.Next(&element1), &element3);
+  ASSERT_EQ(list.Next(&element3), nullptr);
+}
+
+static bool LowerB(const ListElement& a, const ListElement& b) {
+  return a.b < b.b;
+}
+
+TEST_F(LinkedListTest, InsertKeepsOrderTest) {
+  element1.b = 30;
+  element2.b = 10;
+  element3.b = 20;
+
+  list.Insert(&element1, LowerB);
+  ASSERT_EQ(list.Front(), &element1);
+  ASSERT_EQ(list.Next(&element1), nullptr);
+
+  list.Insert(&element2, LowerB);
+  ASSERT_EQ(list.Front(), &element2);
+  ASSERT_EQ(list.Next(&element2), &element1);
+  ASSERT_EQ(list.Next(&element1), nullptr);
+
+  list.Insert(&element3, LowerB);
+  ASSERT_EQ(list.Front(), &element2);
+  ASSERT_EQ(list.Next(&element2), &element3);
+  ASSERT_EQ(list.Next(&element3), &element1);
+  ASSERT_EQ(list.Next(&element1), nullptr);
+}
+
+TEST_F(LinkedListTest, InsertIsStableTest) {
+  element1.b = 10;
+  element2.b = 10;
+  element3.b = 5;
+
+  list.Insert(&element1, LowerB);
+  list.Insert(&element2, LowerB);
+  list.Insert(&element3, LowerB);
+
+  // Equivalent elements keep insertion order
+  ASSERT_EQ(list.Front(), &element3);
+  ASSERT_EQ(list.Next(&element3), &element1);
+  ASSERT_EQ(list.Next(&element1), &element2);
+  ASSERT_EQ(list.Next(&element2), nullptr);
 }
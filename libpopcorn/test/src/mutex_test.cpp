@@ -17,28 +17,40 @@
 
 #include <memory>
 #include <atomic>
+#include <cstdint>
 
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
 
+#include "test/mock_kernel.h"
 #include "test/mock_mcu.h"
 #include "popcorn/primitives/mutex.h"
 
 using testing::StrictMock;
 using testing::InSequence;
 using testing::Invoke;
+using testing::Return;
+using testing::_;
 
 using std::unique_ptr;
 using std::make_unique;
-using std::atomic_flag;
+using std::uintptr_t;
 
+using Popcorn::task_control_block;
 using Hw::g_svc;
 
 class MutexTest: public ::testing::Test {
  private:
   void SetUp() override {
+    // The kernel behind the Syscall API is built on first use and
+    // would take over g_kernel, which the mutex relies on
+    Popcorn::Syscall::Instance();
     Hw::g_mcu = &mcu;
     g_svc = &svc;
+    EXPECT_CALL(mcu, RegisterSyscallImpl(_));
+    kernel = make_unique<StrictMock<MockKernel>>(&mcu);
+    EXPECT_CALL(*kernel, GetCurrentTask())
+      .WillRepeatedly(Invoke([this]() { return current_task; }));
     mutex = make_unique<Popcorn::Mutex>();
   }
 
@@ -49,53 +61,70 @@ class MutexTest: public ::testing::Test {
  protected:
   StrictMock<MockMCU> mcu;
   StrictMock<MockSVC> svc;
+  unique_ptr<StrictMock<MockKernel>> kernel;
   unique_ptr<Popcorn::Mutex> mutex;
 
-  atomic_flag& GetHeldFlag() {
-    return mutex->m_held;
+  task_control_block task1 {};
+  task_control_block task2 {};
+  task_control_block* current_task = &task1;
+
+  std::atomic<uintptr_t>& GetState() {
+    return mutex->m_state;
+  }
+
+  static uintptr_t Owner(const task_control_block* tcb) {
+    return reinterpret_cast<uintptr_t>(tcb);
   }
+
+  static constexpr uintptr_t kKernelOwnedBit =
+    Popcorn::Mutex::kKernelOwnedBit;
 };
 
 TEST_F(MutexTest, CheckInitialState) {
-  EXPECT_EQ(GetHeldFlag().test_and_set(), false);
+  EXPECT_EQ(GetState(), 0U);
 }
 
 TEST_F(MutexTest, CheckCanBeAcquired) {
-  EXPECT_CALL(svc, SupervisorCall(Popcorn::SyscallIdx::Lock));
+  // No system call without contention
   mutex->Lock();
-  EXPECT_EQ(GetHeldFlag().test_and_set(), true);
+  EXPECT_EQ(GetState(), Owner(&task1));
 }
 
 TEST_F(MutexTest, CheckCanBeReleased) {
-  EXPECT_CALL(svc, SupervisorCall(Popcorn::SyscallIdx::Lock));
   mutex->Lock();
-  EXPECT_EQ(GetHeldFlag().test_and_set(), true);
+  EXPECT_EQ(GetState(), Owner(&task1));
+
+  mutex->Unlock();
+  EXPECT_EQ(GetState(), 0U);
+}
+
+TEST_F(MutexTest, UnlockLeavesHandoverToKernel) {
+  mutex->Lock();
 
-  EXPECT_CALL(svc, SupervisorCall(Popcorn::SyscallIdx::Lock));
+  // A waiter showed up, the kernel hands the lock over
+  GetState() |= kKernelOwnedBit;
+  EXPECT_CALL(svc, SupervisorCall(Popcorn::SyscallIdx::Lock))
+    .WillOnce(Invoke([this](Popcorn::SyscallIdx idx) {
+      GetState() = Owner(&task2);
+    }));
   mutex->Unlock();
-  EXPECT_EQ(GetHeldFlag().test_and_set(), false);
+  EXPECT_EQ(GetState(), Owner(&task2));
 }
 
-TEST_F(MutexTest, NotAquiredUntilReleasedByOtherThread) {
+TEST_F(MutexTest, ContendedLockBlocksOnce) {
   InSequence s;
-  EXPECT_CALL(svc, SupervisorCall(Popcorn::SyscallIdx::Lock));
   mutex->Lock();
-  EXPECT_EQ(GetHeldFlag().test_and_set(), true);
-
-  auto release = [this](Popcorn::SyscallIdx idx) {
-    EXPECT_CALL(svc, SupervisorCall(Popcorn::SyscallIdx::Lock));
-    mutex->Unlock();
-    EXPECT_EQ(GetHeldFlag().test_and_set(), false);
-    GetHeldFlag().clear();
-  };
-
-  EXPECT_CALL(svc, SupervisorCall(Popcorn::SyscallIdx::Wait)).Times(10);
-  EXPECT_CALL(svc, SupervisorCall(Popcorn::SyscallIdx::Wait)).WillOnce(Invoke(release));
-  EXPECT_CALL(svc, SupervisorCall(Popcorn::SyscallIdx::Lock));
+  EXPECT_EQ(GetState(), Owner(&task1));
+
+  // Ownership is handed over by the kernel while the task is blocked,
+  // there is no need to retry nor to report the acquired lock.
+  current_task = &task2;
+  EXPECT_CALL(svc, SupervisorCall(Popcorn::SyscallIdx::Wait)).Times(1);
   mutex->Lock();
-  EXPECT_EQ(GetHeldFlag().test_and_set(), true);
+  EXPECT_EQ(GetState(), Owner(&task1));
 
-  EXPECT_CALL(svc, SupervisorCall(Popcorn::SyscallIdx::Lock));
+  // Only the owner can release it without the kernel
+  EXPECT_CALL(svc, SupervisorCall(Popcorn::SyscallIdx::Lock)).Times(1);
   mutex->Unlock();
-  EXPECT_EQ(GetHeldFlag().test_and_set(), false);
+  EXPECT_EQ(GetState(), Owner(&task1));
 }
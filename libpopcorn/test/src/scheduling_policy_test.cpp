@@ -0,0 +1,146 @@
+/*
+ * This file is part of Popcorn
+ * Copyright (c) 2020 Javier Alvarez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+#include <cstddef>
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include "popcorn/core/scheduling_policy.h"
+
+using Popcorn::Priority;
+using Popcorn::task_control_block;
+
+namespace {
+void InitTask(task_control_block* tcb, Priority priority,
+              std::uint64_t deadline = UINT64_MAX) {
+  tcb->priority = priority;
+  tcb->base_priority = priority;
+  tcb->deadline = deadline;
+}
+
+std::uint32_t SliceOf(Priority priority) {
+  return TIME_SLICE_TICKS[static_cast<std::size_t>(priority)];
+}
+}  // namespace
+
+TEST(SchedulingPolicyTest, PreemptionPerPolicy) {
+  EXPECT_TRUE(Popcorn::FixedPriorityPolicy::kPreemptive);
+  EXPECT_TRUE(Popcorn::RoundRobinPolicy::kPreemptive);
+  EXPECT_TRUE(Popcorn::EarliestDeadlineFirstPolicy::kPreemptive);
+  EXPECT_FALSE(Popcorn::CooperativePolicy::kPreemptive);
+}
+
+TEST(SchedulingPolicyTest, FixedPriorityRunsHighestPriorityInFifoOrder) {
+  Popcorn::FixedPriorityPolicy policy;
+  task_control_block idle {};
+  InitTask(&idle, Priority::IDLE);
+  task_control_block first {};
+  InitTask(&first, Priority::Level_3);
+  task_control_block second {};
+  InitTask(&second, Priority::Level_3);
+
+  EXPECT_EQ(policy.GetNextTask(), nullptr);
+  policy.AddReadyTask(&idle);
+  EXPECT_TRUE(policy.IsOnlyIdleReady());
+  policy.AddReadyTask(&first);
+  policy.AddReadyTask(&second);
+  EXPECT_FALSE(policy.IsOnlyIdleReady());
+  EXPECT_EQ(policy.GetNextTask(), &first);
+
+  // Without time slicing the running task is never rotated
+  for (std::uint32_t i = 0; i < SliceOf(Priority::Level_3) + 1; i++) {
+    policy.ConsumeTimeSlice(&first);
+  }
+  EXPECT_EQ(policy.GetNextTask(), &first);
+
+  policy.RemoveReadyTask(&first);
+  EXPECT_EQ(policy.GetNextTask(), &second);
+  policy.RemoveReadyTask(&second);
+  EXPECT_EQ(policy.GetNextTask(), &idle);
+  EXPECT_TRUE(policy.IsOnlyIdleReady());
+}
+
+TEST(SchedulingPolicyTest, RoundRobinRotatesOnExpiredSlice) {
+  Popcorn::RoundRobinPolicy policy;
+  task_control_block first {};
+  InitTask(&first, Priority::Level_3);
+  task_control_block second {};
+  InitTask(&second, Priority::Level_3);
+  policy.AddReadyTask(&first);
+  policy.AddReadyTask(&second);
+
+  std::uint32_t slice = SliceOf(Priority::Level_3);
+  ASSERT_GT(slice, 0U);
+  for (std::uint32_t i = 0; i < slice - 1; i++) {
+    policy.ConsumeTimeSlice(&first);
+  }
+  EXPECT_EQ(policy.GetNextTask(), &first);
+
+  policy.ConsumeTimeSlice(&first);
+  EXPECT_EQ(policy.GetNextTask(), &second);
+  EXPECT_EQ(first.time_slice, slice);
+}
+
+TEST(SchedulingPolicyTest, RoundRobinWithoutPeersReloadsSlice) {
+  Popcorn::RoundRobinPolicy policy;
+  task_control_block lower {};
+  InitTask(&lower, Priority::Level_1);
+  task_control_block task {};
+  InitTask(&task, Priority::Level_3);
+  policy.AddReadyTask(&lower);
+  policy.AddReadyTask(&task);
+
+  std::uint32_t slice = SliceOf(Priority::Level_3);
+  for (std::uint32_t i = 0; i < slice; i++) {
+    policy.ConsumeTimeSlice(&task);
+  }
+  EXPECT_EQ(policy.GetNextTask(), &task);
+  EXPECT_EQ(task.time_slice, slice);
+}
+
+TEST(SchedulingPolicyTest, EarliestDeadlineFirstRunsEarliestDeadline) {
+  Popcorn::EarliestDeadlineFirstPolicy policy;
+  task_control_block idle {};
+  InitTask(&idle, Priority::IDLE);
+  task_control_block high {};
+  InitTask(&high, Priority::Level_9);
+  task_control_block early {};
+  InitTask(&early, Priority::Level_1, 10);
+  task_control_block late {};
+  InitTask(&late, Priority::Level_5, 20);
+
+  policy.AddReadyTask(&idle);
+  EXPECT_TRUE(policy.IsOnlyIdleReady());
+  policy.AddReadyTask(&high);
+  policy.AddReadyTask(&late);
+  policy.AddReadyTask(&early);
+  EXPECT_FALSE(policy.IsOnlyIdleReady());
+  EXPECT_EQ(policy.GetNextTask(), &early);
+
+  // Time slices have no effect
+  for (std::uint32_t i = 0; i < SliceOf(Priority::Level_1) + 1; i++) {
+    policy.ConsumeTimeSlice(&early);
+  }
+  EXPECT_EQ(policy.GetNextTask(), &early);
+
+  policy.RemoveReadyTask(&early);
+  EXPECT_EQ(policy.GetNextTask(), &late);
+  policy.RemoveReadyTask(&late);
+  EXPECT_EQ(policy.GetNextTask(), &high);
+}
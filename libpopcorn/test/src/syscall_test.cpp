@@ -52,7 +52,7 @@ class SyscallTest: public ::testing::Test {
   void TearDown() override { }
 
  protected:
-  void SyscallWait(const Lockable& lockable) {
+  void SyscallWait(Lockable& lockable) {
     syscall->Wait(lockable);
   }
 
@@ -72,6 +72,23 @@ TEST_F(SyscallTest, CreateTask_Test) {
   syscall->CreateTask(func, 0, Priority::Level_0, "", 0);
 }
 
+TEST_F(SyscallTest, CreateTaskStatic_Test) {
+  EXPECT_CALL(svc, SupervisorCall(SyscallIdx::CreateTaskStatic));
+  static_task_params params = { Priority::Level_0, "", nullptr, nullptr, 0 };
+  syscall->CreateTaskStatic(func, 0, params);
+}
+
+TEST_F(SyscallTest, CreatePeriodicTask_Test) {
+  EXPECT_CALL(svc, SupervisorCall(SyscallIdx::CreatePeriodicTask));
+  periodic_task_params params = { Priority::Level_0, "", 0, 10, 0 };
+  syscall->CreatePeriodicTask(func, 0, params);
+}
+
+TEST_F(SyscallTest, WaitForNextPeriod_Test) {
+  EXPECT_CALL(svc, SupervisorCall(SyscallIdx::WaitForNextPeriod));
+  syscall->WaitForNextPeriod();
+}
+
 TEST_F(SyscallTest, DestroyTask_Test) {
   EXPECT_CALL(svc, SupervisorCall(SyscallIdx::DestroyTask));
   syscall->DestroyTask();
@@ -0,0 +1,80 @@
+/*
+ * This file is part of Popcorn
+ * Copyright (c) 2020 Javier Alvarez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include "popcorn/core/task_cache.h"
+
+using Popcorn::TaskCache;
+using Popcorn::task_control_block;
+
+namespace {
+void InitTask(task_control_block* tcb, std::uint32_t stack_size) {
+  tcb->stack_size = stack_size;
+}
+}  // namespace
+
+TEST(TaskCacheTest, ReusesTasksWithSameStackSize) {
+  TaskCache<4> cache;
+  task_control_block small {};
+  InitTask(&small, 256);
+  task_control_block large {};
+  InitTask(&large, 1024);
+
+  EXPECT_EQ(cache.Take(256), nullptr);
+  EXPECT_TRUE(cache.Park(&small));
+  EXPECT_TRUE(cache.Park(&large));
+  EXPECT_EQ(cache.Size(), 2U);
+
+  EXPECT_EQ(cache.Take(512), nullptr);
+  EXPECT_EQ(cache.Take(256), &small);
+  EXPECT_EQ(cache.Take(256), nullptr);
+  EXPECT_EQ(cache.Take(1024), &large);
+  EXPECT_EQ(cache.Size(), 0U);
+}
+
+TEST(TaskCacheTest, ReusesMostRecentlyParkedFirst) {
+  TaskCache<4> cache;
+  task_control_block first {};
+  InitTask(&first, 256);
+  task_control_block second {};
+  InitTask(&second, 256);
+
+  cache.Park(&first);
+  cache.Park(&second);
+  EXPECT_EQ(cache.Take(256), &second);
+  EXPECT_EQ(cache.Take(256), &first);
+}
+
+TEST(TaskCacheTest, RejectsTasksWhenFull) {
+  TaskCache<1> cache;
+  task_control_block first {};
+  InitTask(&first, 256);
+  task_control_block second {};
+  InitTask(&second, 256);
+
+  EXPECT_TRUE(cache.Park(&first));
+  EXPECT_FALSE(cache.Park(&second));
+  EXPECT_EQ(cache.Size(), 1U);
+
+  TaskCache<0> disabled;
+  EXPECT_FALSE(disabled.Park(&second));
+  EXPECT_EQ(disabled.Take(256), nullptr);
+}
@@ -0,0 +1,212 @@
+/*
+ * This file is part of Popcorn
+ * Copyright (c) 2020 Javier Alvarez
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include "popcorn/utils/tlsf.h"
+#include "test/mock_assert.h"
+
+using ::testing::StrictMock;
+using ::testing::_;
+
+using Popcorn::Tlsf;
+
+class TlsfTest: public ::testing::Test {
+ protected:
+  void SetUp() override {
+    g_platform = &platform;
+  }
+
+  void TearDown() override {
+    g_platform = nullptr;
+  }
+
+  static std::size_t HeaderSize() {
+    return Tlsf::kHeaderSize;
+  }
+
+  static std::size_t HeapPayload() {
+    return sizeof(memory) - 2 * HeaderSize();
+  }
+
+  static void Mapping(std::size_t size, std::uint32_t* fl,
+                      std::uint32_t* sl) {
+    Tlsf::Mapping(size, fl, sl);
+  }
+
+  static void MappingSearch(std::size_t size, std::uint32_t* fl,
+                            std::uint32_t* sl) {
+    Tlsf::MappingSearch(size, fl, sl);
+  }
+
+  static bool IsAligned(const void* ptr, std::size_t alignment) {
+    return reinterpret_cast<std::uintptr_t>(ptr) % alignment == 0;
+  }
+
+  alignas(8) static std::uint8_t memory[4096];
+  Tlsf heap { memory, sizeof(memory) };
+  StrictMock<MockPlatform> platform;
+};
+
+alignas(8) std::uint8_t TlsfTest::memory[4096];
+
+TEST_F(TlsfTest, MapsSizesToSegregatedLists) {
+  std::uint32_t fl;
+  std::uint32_t sl;
+
+  // Small blocks are split linearly
+  Mapping(8, &fl, &sl);
+  EXPECT_EQ(fl, 0U);
+  EXPECT_EQ(sl, 1U);
+  Mapping(120, &fl, &sl);
+  EXPECT_EQ(fl, 0U);
+  EXPECT_EQ(sl, 15U);
+
+  Mapping(128, &fl, &sl);
+  EXPECT_EQ(fl, 1U);
+  EXPECT_EQ(sl, 0U);
+  Mapping(160, &fl, &sl);
+  EXPECT_EQ(fl, 1U);
+  EXPECT_EQ(sl, 4U);
+  Mapping(1024 + 3 * 64, &fl, &sl);
+  EXPECT_EQ(fl, 4U);
+  EXPECT_EQ(sl, 3U);
+
+  // Searches round up to the next list
+  MappingSearch(129, &fl, &sl);
+  EXPECT_EQ(fl, 1U);
+  EXPECT_EQ(sl, 1U);
+  MappingSearch(255, &fl, &sl);
+  EXPECT_EQ(fl, 2U);
+  EXPECT_EQ(sl, 0U);
+}
+
+TEST_F(TlsfTest, AllocatesAlignedBlocksUntilExhausted) {
+  EXPECT_EQ(heap.Allocate(0), nullptr);
+  EXPECT_EQ(heap.FreeBytes(), HeapPayload());
+
+  std::uint8_t* previous = nullptr;
+  std::size_t count = 0;
+  while (auto* ptr = static_cast<std::uint8_t*>(heap.Allocate(20))) {
+    EXPECT_TRUE(IsAligned(ptr, Tlsf::kAlignment));
+    EXPECT_TRUE(heap.Contains(ptr));
+    EXPECT_GE(heap.BlockSize(ptr), 20U);
+    if (previous != nullptr) {
+      EXPECT_GE(ptr, previous + heap.BlockSize(previous));
+    }
+    std::memset(ptr, 0xA5, 20);
+    previous = ptr;
+    count++;
+  }
+
+  EXPECT_GT(count, sizeof(memory) / 64);
+  EXPECT_LT(heap.FreeBytes(), 24U);
+}
+
+TEST_F(TlsfTest, FreeMergesAdjacentBlocks) {
+  void* first = heap.Allocate(100);
+  void* second = heap.Allocate(200);
+  void* third = heap.Allocate(300);
+  ASSERT_NE(third, nullptr);
+
+  heap.Free(first);
+  heap.Free(third);
+  EXPECT_LT(heap.LargestFreeBlock(), HeapPayload());
+
+  heap.Free(second);
+  EXPECT_EQ(heap.FreeBytes(), HeapPayload());
+  EXPECT_EQ(heap.LargestFreeBlock(), HeapPayload());
+
+  // Freeing nullptr is ignored
+  heap.Free(nullptr);
+}
+
+TEST_F(TlsfTest, ReusesFreedBlock) {
+  void* first = heap.Allocate(100);
+  void* second = heap.Allocate(100);
+  ASSERT_NE(second, nullptr);
+
+  heap.Free(first);
+  EXPECT_EQ(heap.Allocate(100), first);
+}
+
+TEST_F(TlsfTest, AllocateAlignedHonoursAlignment) {
+  void* unaligned = heap.Allocate(8);
+  ASSERT_NE(unaligned, nullptr);
+
+  for (std::size_t alignment : { 8U, 16U, 64U, 256U, 1024U }) {
+    void* ptr = heap.AllocateAligned(alignment, 40);
+    ASSERT_NE(ptr, nullptr);
+    EXPECT_TRUE(IsAligned(ptr, alignment));
+    EXPECT_GE(heap.BlockSize(ptr), 40U);
+    heap.Free(ptr);
+  }
+
+  heap.Free(unaligned);
+  EXPECT_EQ(heap.FreeBytes(), HeapPayload());
+  EXPECT_EQ(heap.AllocateAligned(64, sizeof(memory)), nullptr);
+}
+
+TEST_F(TlsfTest, ReallocateGrowsInPlaceWhenNextBlockIsFree) {
+  auto* ptr = static_cast<std::uint8_t*>(heap.Allocate(32));
+  std::memset(ptr, 0x5A, 32);
+
+  EXPECT_EQ(heap.Reallocate(ptr, 512), ptr);
+  EXPECT_GE(heap.BlockSize(ptr), 512U);
+  for (std::size_t i = 0; i < 32; i++) {
+    EXPECT_EQ(ptr[i], 0x5A);
+  }
+
+  // Shrinking gives the tail back
+  EXPECT_EQ(heap.Reallocate(ptr, 16), ptr);
+  EXPECT_EQ(heap.FreeBytes(),
+            HeapPayload() - heap.BlockSize(ptr) - HeaderSize());
+}
+
+TEST_F(TlsfTest, ReallocateMovesWhenNextBlockIsUsed) {
+  auto* ptr = static_cast<std::uint8_t*>(heap.Allocate(32));
+  void* next = heap.Allocate(32);
+  ASSERT_NE(next, nullptr);
+  std::memset(ptr, 0x3C, 32);
+
+  auto* moved = static_cast<std::uint8_t*>(heap.Reallocate(ptr, 256));
+  ASSERT_NE(moved, nullptr);
+  EXPECT_NE(moved, ptr);
+  for (std::size_t i = 0; i < 32; i++) {
+    EXPECT_EQ(moved[i], 0x3C);
+  }
+
+  // On failure the block is left untouched
+  EXPECT_EQ(heap.Reallocate(moved, sizeof(memory)), nullptr);
+  EXPECT_EQ(moved[0], 0x3C);
+
+  EXPECT_EQ(heap.Reallocate(nullptr, 8), ptr);
+  EXPECT_EQ(heap.Reallocate(ptr, 0), nullptr);
+}
+
+TEST_F(TlsfTest, FreeForeignBlockAsserts) {
+  ASSERT_NE(heap.Allocate(8), nullptr);
+
+  std::uint64_t foreign[4] = {};
+  EXPECT_CALL(platform, Assert(_));
+  heap.Free(&foreign[2]);
+}